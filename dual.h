@@ -0,0 +1,126 @@
+#ifndef DUAL_H
+#define DUAL_H
+
+#include <math.h>
+
+// This document is Licensed under Creative Commons CC0.
+// To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+// to this document to the public domain worldwide.
+// This document is distributed without any warranty.
+// You should have received a copy of the CC0 Public Domain Dedication along with this document.
+// If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+// Forward-mode automatic differentiation with dual numbers.
+// A Dual carries a value and its partial derivatives with respect to DUAL_N chosen inputs. Every operation
+// applies the chain rule to all DUAL_N derivatives at once, so evaluating a function on Duals yields its
+// value and its gradient in a single pass, at a fixed multiple of the cost of the plain evaluation.
+// Define DUAL_N before including this header to change the number of inputs.
+
+#ifndef DUAL_N
+#define DUAL_N 6
+#endif
+
+typedef struct {
+    double v;          // Value
+    double d[DUAL_N];  // Partial derivatives of the value with respect to each input
+} Dual;
+
+// Function to make a constant (all derivatives zero)
+static inline Dual dual_const(double v) {
+    Dual r;
+    r.v = v;
+    for (int i = 0; i < DUAL_N; i++) r.d[i] = 0.0;
+    return r;
+}
+
+// Function to make input number i of the differentiation
+static inline Dual dual_var(double v, int i) {
+    Dual r = dual_const(v);
+    r.d[i] = 1.0;
+    return r;
+}
+
+static inline Dual dual_add(Dual a, Dual b) {
+    Dual r;
+    r.v = a.v + b.v;
+    for (int i = 0; i < DUAL_N; i++) r.d[i] = a.d[i] + b.d[i];
+    return r;
+}
+
+static inline Dual dual_sub(Dual a, Dual b) {
+    Dual r;
+    r.v = a.v - b.v;
+    for (int i = 0; i < DUAL_N; i++) r.d[i] = a.d[i] - b.d[i];
+    return r;
+}
+
+static inline Dual dual_neg(Dual a) {
+    Dual r;
+    r.v = -a.v;
+    for (int i = 0; i < DUAL_N; i++) r.d[i] = -a.d[i];
+    return r;
+}
+
+static inline Dual dual_mul(Dual a, Dual b) {
+    Dual r;
+    r.v = a.v * b.v;
+    for (int i = 0; i < DUAL_N; i++) r.d[i] = a.d[i] * b.v + a.v * b.d[i];
+    return r;
+}
+
+static inline Dual dual_div(Dual a, Dual b) {
+    Dual r;
+    r.v = a.v / b.v;
+    for (int i = 0; i < DUAL_N; i++) r.d[i] = (a.d[i] - r.v * b.d[i]) / b.v;
+    return r;
+}
+
+// Function to multiply by a constant
+static inline Dual dual_scale(Dual a, double k) {
+    Dual r;
+    r.v = a.v * k;
+    for (int i = 0; i < DUAL_N; i++) r.d[i] = a.d[i] * k;
+    return r;
+}
+
+// Function to add a constant
+static inline Dual dual_shift(Dual a, double k) {
+    a.v += k;
+    return a;
+}
+
+static inline Dual dual_sin(Dual a) {
+    double c = cos(a.v);
+    Dual r;
+    r.v = sin(a.v);
+    for (int i = 0; i < DUAL_N; i++) r.d[i] = c * a.d[i];
+    return r;
+}
+
+static inline Dual dual_cos(Dual a) {
+    double s = sin(a.v);
+    Dual r;
+    r.v = cos(a.v);
+    for (int i = 0; i < DUAL_N; i++) r.d[i] = -s * a.d[i];
+    return r;
+}
+
+static inline Dual dual_sqrt(Dual a) {
+    Dual r;
+    r.v = sqrt(a.v);
+    double k = r.v > 0.0 ? 0.5 / r.v : 0.0;
+    for (int i = 0; i < DUAL_N; i++) r.d[i] = k * a.d[i];
+    return r;
+}
+
+// Function to take the absolute value; the derivative at zero is taken as zero
+static inline Dual dual_abs(Dual a) {
+    return a.v < 0.0 ? dual_neg(a) : a;
+}
+
+// Function to pick the larger value; the derivative follows the branch taken, as for fmax()
+static inline Dual dual_max(Dual a, Dual b) {
+    return a.v >= b.v ? a : b;
+}
+
+#endif
@@ -0,0 +1,271 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+
+// This document is Licensed under Creative Commons CC0.
+// To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+// to this document to the public domain worldwide.
+// This document is distributed without any warranty.
+// You should have received a copy of the CC0 Public Domain Dedication along with this document.
+// If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+/*
+gcc -O2 -shared -fPIC $(python3-config --includes) exophysics.c -o exophysics$(python3-config --extension-suffix) -lm
+*/
+
+// Python module over physics.h, the same physics simulation.c runs.
+// Batched calls take float64 arrays (numpy or anything else with the buffer protocol), update them in place
+// without copying, and release the GIL while they run so several Python threads can step legs in parallel.
+
+// Controller noise comes from a per-thread generator seeded by each call instead of the global rand()
+static _Thread_local uint64_t rng_state;
+
+static int next_rand(void) {
+    uint64_t z = (rng_state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return (int)((z ^ (z >> 31)) >> 33);
+}
+
+#define PHYSICS_RAND() next_rand()
+#include "physics.h"
+
+// Batched calls running without the GIL. They read the ground settings of physics.h, so set_ground() refuses to
+// change them while any is running; only touched with the GIL held, so a plain int suffices
+static int running_calls = 0;
+
+#define MAX_STEPS 1000    // Trajectory length of simulate_arm() in simulation.c
+#define CHUNK PHYSICS_BLOCK  // Legs advanced together through all steps of a rollout
+
+// Function to borrow a C-contiguous float64 buffer; returns its length or -1 with an exception set
+static Py_ssize_t get_doubles(PyObject *obj, Py_buffer *view, int writable, const char *name) {
+    int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+    if (PyObject_GetBuffer(obj, view, flags) < 0) {
+        PyErr_Format(PyExc_TypeError, "%s must be a %sC-contiguous float64 array", name, writable ? "writable " : "");
+        return -1;
+    }
+    const char *format = view->format ? view->format : "B";
+    if (view->itemsize != sizeof(double) || (strcmp(format, "d") != 0 && strcmp(format, "=d") != 0 &&
+                                             strcmp(format, "<d") != 0 && strcmp(format, "@d") != 0)) {
+        PyErr_Format(PyExc_TypeError, "%s must have dtype float64", name);
+        PyBuffer_Release(view);
+        return -1;
+    }
+    return view->len / (Py_ssize_t)sizeof(double);
+}
+
+// Function to borrow several equally long float64 buffers at once
+static Py_ssize_t get_legs(PyObject **objs, Py_buffer *views, int count, int writable_count, const char **names) {
+    Py_ssize_t n = -1;
+    for (int i = 0; i < count; i++) {
+        Py_ssize_t len = get_doubles(objs[i], &views[i], i < writable_count, names[i]);
+        if (len >= 0 && n >= 0 && len != n) {
+            PyErr_Format(PyExc_ValueError, "%s has %zd elements, expected %zd", names[i], len, n);
+            PyBuffer_Release(&views[i]);
+            len = -1;
+        }
+        if (len < 0) {
+            while (--i >= 0) PyBuffer_Release(&views[i]);
+            return -1;
+        }
+        n = len;
+    }
+    return n;
+}
+
+static void release_all(Py_buffer *views, int count) {
+    for (int i = 0; i < count; i++) PyBuffer_Release(&views[i]);
+}
+
+// compute_gravitational_torques(theta1, theta2) -> (tau1, tau2)
+static PyObject *py_compute_gravitational_torques(PyObject *self, PyObject *args) {
+    double theta1, theta2, tau1, tau2;
+    if (!PyArg_ParseTuple(args, "dd", &theta1, &theta2)) return NULL;
+    compute_gravitational_torques(theta1, theta2, &tau1, &tau2);
+    return Py_BuildValue("dd", tau1, tau2);
+}
+
+// simulate_step(theta1, omega1, theta2, omega2, tau1, tau2) -> (theta1, omega1, theta2, omega2)
+static PyObject *py_simulate_step(PyObject *self, PyObject *args) {
+    double theta1, omega1, theta2, omega2, tau1, tau2;
+    if (!PyArg_ParseTuple(args, "dddddd", &theta1, &omega1, &theta2, &omega2, &tau1, &tau2)) return NULL;
+    simulate_step(&theta1, &omega1, &theta2, &omega2, tau1, tau2);
+    return Py_BuildValue("dddd", theta1, omega1, theta2, omega2);
+}
+
+// step_batch(theta1, omega1, theta2, omega2, tau1, tau2): one step for every leg, state updated in place
+static PyObject *py_step_batch(PyObject *self, PyObject *args) {
+    static const char *names[] = { "theta1", "omega1", "theta2", "omega2", "tau1", "tau2" };
+    PyObject *objs[6];
+    Py_buffer views[6];
+    if (!PyArg_ParseTuple(args, "OOOOOO", &objs[0], &objs[1], &objs[2], &objs[3], &objs[4], &objs[5])) return NULL;
+    Py_ssize_t n = get_legs(objs, views, 6, 4, names);
+    if (n < 0) return NULL;
+
+    running_calls++;
+    Py_BEGIN_ALLOW_THREADS
+    for (Py_ssize_t start = 0; start < n; start += INT32_MAX) {
+        int count = (int)(n - start < INT32_MAX ? n - start : INT32_MAX);
+        simulate_step_batch(count,
+                            (double *)views[0].buf + start, (double *)views[1].buf + start,
+                            (double *)views[2].buf + start, (double *)views[3].buf + start,
+                            (const double *)views[4].buf + start, (const double *)views[5].buf + start);
+    }
+    Py_END_ALLOW_THREADS
+    running_calls--;
+
+    release_all(views, 6);
+    Py_RETURN_NONE;
+}
+
+// rollout(theta1, omega1, theta2, omega2, steps, seed=0): gravity + noisy PD for every leg, in place
+static PyObject *py_rollout(PyObject *self, PyObject *args, PyObject *kwargs) {
+    static char *keywords[] = { "theta1", "omega1", "theta2", "omega2", "steps", "seed", NULL };
+    static const char *names[] = { "theta1", "omega1", "theta2", "omega2" };
+    PyObject *objs[4];
+    Py_buffer views[4];
+    int steps;
+    unsigned long long seed = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOOi|K", keywords,
+                                     &objs[0], &objs[1], &objs[2], &objs[3], &steps, &seed)) return NULL;
+    Py_ssize_t n = get_legs(objs, views, 4, 4, names);
+    if (n < 0) return NULL;
+
+    double *th1 = views[0].buf, *om1 = views[1].buf, *th2 = views[2].buf, *om2 = views[3].buf;
+
+    running_calls++;
+    Py_BEGIN_ALLOW_THREADS
+    rng_state = seed;
+    double tau1[CHUNK], tau2[CHUNK];
+    for (Py_ssize_t start = 0; start < n; start += CHUNK) {
+        int count = (int)(n - start < CHUNK ? n - start : CHUNK);
+        for (int s = 0; s < steps; s++) {
+            compute_external_torques_batch(count, th1 + start, om1 + start, th2 + start, om2 + start, tau1, tau2);
+            for (int i = 0; i < count; i++) {
+                Py_ssize_t k = start + i;
+                compute_control_torques(th1[k], om1[k], th2[k], om2[k], &tau1[i], &tau2[i]);
+            }
+            integrate_step_batch(count, th1 + start, om1 + start, th2 + start, om2 + start, tau1, tau2);
+        }
+    }
+    Py_END_ALLOW_THREADS
+    running_calls--;
+
+    release_all(views, 4);
+    Py_RETURN_NONE;
+}
+
+// generate_dataset(out, start_theta1, start_theta2, seed=0) -> rows written.
+// Runs the simulate_arm() trajectory of simulation.c from each start pair and writes rows in the
+// robot-control.txt layout into out (a float64 array with 8 values per row) until it is full.
+static PyObject *py_generate_dataset(PyObject *self, PyObject *args, PyObject *kwargs) {
+    static char *keywords[] = { "out", "start_theta1", "start_theta2", "seed", NULL };
+    static const char *names[] = { "start_theta1", "start_theta2" };
+    PyObject *out_obj, *objs[2];
+    Py_buffer out_view, views[2];
+    unsigned long long seed = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO|K", keywords, &out_obj, &objs[0], &objs[1], &seed)) {
+        return NULL;
+    }
+    Py_ssize_t out_len = get_doubles(out_obj, &out_view, 1, "out");
+    if (out_len < 0) return NULL;
+    Py_ssize_t n = get_legs(objs, views, 2, 0, names);
+    if (n < 0) {
+        PyBuffer_Release(&out_view);
+        return NULL;
+    }
+
+    double *out = out_view.buf;
+    const double *starts1 = views[0].buf, *starts2 = views[1].buf;
+    Py_ssize_t capacity = out_len / 8, rows = 0;
+
+    running_calls++;
+    Py_BEGIN_ALLOW_THREADS
+    rng_state = seed;
+    for (Py_ssize_t t = 0; t < n && rows < capacity; t++) {
+        double theta1 = starts1[t], theta2 = starts2[t], omega1 = 0.0, omega2 = 0.0;
+        double prev_theta1 = theta1, prev_theta2 = theta2;
+        for (int i = 0; i < MAX_STEPS && rows < capacity; i++) {
+            double start_theta1 = theta1, start_theta2 = theta2;
+            double tau1 = 0.0, tau2 = 0.0;
+            compute_gravitational_torques(theta1, theta2, &tau1, &tau2);
+            compute_control_torques(theta1, omega1, theta2, omega2, &tau1, &tau2);
+            simulate_step(&theta1, &omega1, &theta2, &omega2, tau1, tau2);
+
+            double *row = out + rows++ * 8;
+            row[0] = prev_theta1; row[1] = prev_theta2;
+            row[2] = start_theta1; row[3] = start_theta2;
+            row[4] = theta1; row[5] = theta2;
+            row[6] = tau1; row[7] = tau2;
+
+            prev_theta1 = start_theta1;
+            prev_theta2 = start_theta2;
+            if (fabs(theta1) < 0.01 && fabs(omega1) < 0.01 && fabs(theta2) < 0.01 && fabs(omega2) < 0.01) break;
+        }
+    }
+    Py_END_ALLOW_THREADS
+    running_calls--;
+
+    PyBuffer_Release(&out_view);
+    release_all(views, 2);
+    return PyLong_FromSsize_t(rows);
+}
+
+// set_ground(y=None): move the ground plane, or remove it with None; not while a batched call runs
+static PyObject *py_set_ground(PyObject *self, PyObject *args) {
+    PyObject *y = Py_None;
+    if (!PyArg_ParseTuple(args, "|O", &y)) return NULL;
+    if (running_calls > 0) {
+        PyErr_SetString(PyExc_RuntimeError, "set_ground() called while a batched call is running in another thread");
+        return NULL;
+    }
+    if (y == Py_None) {
+        use_contact = 0;
+    } else {
+        double value = PyFloat_AsDouble(y);
+        if (value == -1.0 && PyErr_Occurred()) return NULL;
+        ground_y = value;
+        use_contact = 1;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef methods[] = {
+    { "compute_gravitational_torques", py_compute_gravitational_torques, METH_VARARGS,
+      "compute_gravitational_torques(theta1, theta2) -> (tau1, tau2)" },
+    { "simulate_step", py_simulate_step, METH_VARARGS,
+      "simulate_step(theta1, omega1, theta2, omega2, tau1, tau2) -> (theta1, omega1, theta2, omega2)" },
+    { "step_batch", py_step_batch, METH_VARARGS,
+      "step_batch(theta1, omega1, theta2, omega2, tau1, tau2)\n\n"
+      "Advance every leg by one step; the four state arrays are updated in place." },
+    { "rollout", (PyCFunction)(void (*)(void))py_rollout, METH_VARARGS | METH_KEYWORDS,
+      "rollout(theta1, omega1, theta2, omega2, steps, seed=0)\n\n"
+      "Run gravity plus the noisy PD controller for steps steps on every leg, in place." },
+    { "generate_dataset", (PyCFunction)(void (*)(void))py_generate_dataset, METH_VARARGS | METH_KEYWORDS,
+      "generate_dataset(out, start_theta1, start_theta2, seed=0) -> rows\n\n"
+      "Fill out (float64, 8 values per row) with simulation.c trajectories from each start pair." },
+    { "set_ground", py_set_ground, METH_VARARGS,
+      "set_ground(y=None)\n\nSet the ground height relative to the hip (y up, the leg hangs down), or remove the ground with None.\n"
+      "Raises RuntimeError while step_batch(), rollout() or generate_dataset() runs in another thread." },
+    { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef module = {
+    PyModuleDef_HEAD_INIT, "exophysics", "Exoskeleton leg physics from physics.h", -1, methods
+};
+
+PyMODINIT_FUNC PyInit_exophysics(void) {
+    PyObject *m = PyModule_Create(&module);
+    if (m == NULL) return NULL;
+    PyModule_AddObject(m, "G", PyFloat_FromDouble(G));
+    PyModule_AddObject(m, "L1", PyFloat_FromDouble(L1));
+    PyModule_AddObject(m, "L2", PyFloat_FromDouble(L2));
+    PyModule_AddObject(m, "M1", PyFloat_FromDouble(M1));
+    PyModule_AddObject(m, "M2", PyFloat_FromDouble(M2));
+    PyModule_AddObject(m, "DT", PyFloat_FromDouble(DT));
+    PyModule_AddObject(m, "KP1", PyFloat_FromDouble(KP1));
+    PyModule_AddObject(m, "KD1", PyFloat_FromDouble(KD1));
+    PyModule_AddObject(m, "KP2", PyFloat_FromDouble(KP2));
+    PyModule_AddObject(m, "KD2", PyFloat_FromDouble(KD2));
+    return m;
+}
@@ -0,0 +1,571 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "physics.h"
+#include "mpc.h"
+
+// This document is Licensed under Creative Commons CC0.
+// To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+// to this document to the public domain worldwide.
+// This document is distributed without any warranty.
+// You should have received a copy of the CC0 Public Domain Dedication along with this document.
+// If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+/*
+gcc -O2 generate.c -o generate -lm; ./generate --job dataset-job --trajectories 100000
+./generate --job DIR [--trajectories N] [--batch B] [--seed S] [--spread RAD] [--mpc] [--ground Y | --no-contact]
+           [--workers W] [--keep-shards]
+*/
+
+// Multi-process dataset generation: a coordinator and one worker process per core.
+// Trajectory i starts from angles drawn from the job seed and runs exactly like `./simulation θ1 θ2 seed_i` with the
+// same physics options (--ground, --no-contact, --mpc), including the early exit of simulate_arm(), so trajectories
+// have very different lengths. With --mpc a tick that overruns its budget falls back to PD, as in ./simulation, so
+// those trajectories depend on timing. They are grouped
+// into batches; each worker owns a range of pending batches in shared memory, takes work from the front of its
+// range and, once it runs dry, steals the back half of another worker's range. Ranges are a packed
+// (head, tail) pair updated by compare-and-swap, so there are no locks to be left held by a crashed worker.
+//
+// Each finished batch is written to its own shard file (renamed into place when complete) and recorded in
+// the job manifest, so an interrupted job resumes where it stopped. The coordinator reports progress,
+// restarts workers that crash, gives up on a batch after MAX_ATTEMPTS crashes and on a worker after
+// MAX_WORKER_CRASHES crashes outside any batch, and finally merges the shards
+// into dataset.txt in the robot-control.txt format.
+
+#define MAX_STEPS 1000          // Trajectory length limit of simulate_arm() in simulation.c
+#define MAX_WORKERS 256
+#define MAX_ATTEMPTS 3          // Crashes on one batch before it is recorded as failed
+#define MAX_WORKER_CRASHES 3    // Crashes of one worker outside any batch before it is no longer restarted
+#define MANIFEST_VERSION 1
+
+// Batch states in shared memory
+enum { BATCH_PENDING, BATCH_DONE, BATCH_FAILED };
+
+// Per-worker state, one cache line each
+typedef struct {
+    _Atomic uint64_t range;     // Positions [head, tail) of the pending array, head in the low 32 bits
+    _Atomic int current;        // Batch being generated, or -1
+    pid_t pid;
+} __attribute__((aligned(64))) WorkerSlot;
+
+// Memory shared by the coordinator and the workers
+typedef struct {
+    _Atomic long trajectories_done;
+    _Atomic long rows_done;
+    _Atomic int batches_done;
+    int workers;
+    WorkerSlot slots[MAX_WORKERS];
+} Shared;
+
+// Job parameters, recorded in the manifest
+typedef struct {
+    long trajectories;
+    int batch_size;
+    uint64_t seed;
+    double spread;
+    double ground;      // Ground height, as ./simulation --ground
+    int contact;        // 0 for ./simulation --no-contact
+    int mpc;            // 1 for ./simulation --mpc
+} Job;
+
+Job job = { 10000, 64, 1, 0.6, GROUND_Y, 1, 0 };
+const char *job_dir = NULL;
+Shared *shared = NULL;
+_Atomic unsigned char *batch_state = NULL;   // One entry per batch, shared
+int *pending = NULL;                         // Batches still to generate, shared; ranges index into it
+int batch_count = 0;
+int manifest_fd = -1;
+pid_t coordinator_pid = 0;
+
+// Function to advance a splitmix64 generator
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Function to read a monotonic clock in seconds
+static double now_seconds() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static uint64_t pack_range(uint32_t head, uint32_t tail) {
+    return (uint64_t)tail << 32 | head;
+}
+
+// Function to derive the start angles and noise seed of trajectory i.
+// Angles are rounded to the 6 decimals ./simulation would be given on its command line.
+static void trajectory_setup(long i, double *theta1, double *theta2, unsigned int *seed) {
+    uint64_t state = job.seed * 0x2545f4914f6cdd1dULL + (uint64_t)i;
+    double u1 = (next_random(&state) >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+    double u2 = (next_random(&state) >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+    *theta1 = round(u1 * job.spread * 1e6) / 1e6;
+    *theta2 = round(u2 * job.spread * 1e6) / 1e6;
+    *seed = (unsigned int)(next_random(&state) >> 32);
+}
+
+// Function to write one trajectory in the simulation.c format (no header); returns the number of rows
+int write_trajectory(FILE *out, double theta1, double theta2, unsigned int seed) {
+    double omega1 = 0.0, omega2 = 0.0;
+    double prev_theta1 = theta1, prev_theta2 = theta2;
+    int rows = 0;
+
+    srand(seed);
+    mpc_reset();
+    for (int i = 0; i < MAX_STEPS; i++) {
+        double start_theta1 = theta1, start_theta2 = theta2;
+        double tau1 = 0.0, tau2 = 0.0;
+        compute_gravitational_torques(theta1, theta2, &tau1, &tau2);
+        if (job.mpc) {
+            compute_mpc_torques(theta1, omega1, theta2, omega2, &tau1, &tau2);
+        } else {
+            compute_control_torques(theta1, omega1, theta2, omega2, &tau1, &tau2);
+        }
+        simulate_step(&theta1, &omega1, &theta2, &omega2, tau1, tau2);
+
+        fprintf(out, "%.6f\t%.6f\t%.6f\t%.6f\t%.6f\t%.6f\t%.2f\t%.2f\n",
+                prev_theta1, prev_theta2, start_theta1, start_theta2, theta1, theta2, tau1, tau2);
+        rows++;
+        prev_theta1 = start_theta1;
+        prev_theta2 = start_theta2;
+
+        // Same convergence check as simulate_arm()
+        if (fabs(theta1) < 0.01 && fabs(omega1) < 0.01 && fabs(theta2) < 0.01 && fabs(omega2) < 0.01) break;
+    }
+    return rows;
+}
+
+// Function to build the path of a job file
+static void job_path(char *path, size_t size, const char *name) {
+    snprintf(path, size, "%s/%s", job_dir, name);
+}
+
+static void shard_path(char *path, size_t size, int batch, const char *suffix) {
+    snprintf(path, size, "%s/batch-%06d%s", job_dir, batch, suffix);
+}
+
+// Function to append one line to the manifest (single write() on an O_APPEND descriptor, so lines never interleave)
+static void manifest_append(const char *format, long a, long b) {
+    char line[128];
+    int length = snprintf(line, sizeof(line), format, a, b);
+    if (write(manifest_fd, line, length) != length) {
+        fprintf(stderr, "Warning: could not append to the manifest: %s\n", strerror(errno));
+    }
+}
+
+// Function to generate one batch into its shard file; returns 0 on success
+int run_batch(int batch) {
+    char tmp[4096], path[4096];
+    shard_path(tmp, sizeof(tmp), batch, ".tmp");
+    shard_path(path, sizeof(path), batch, ".txt");
+    FILE *out = fopen(tmp, "w");
+    if (out == NULL) return -1;
+
+    long first = (long)batch * job.batch_size;
+    long last = first + job.batch_size < job.trajectories ? first + job.batch_size : job.trajectories;
+    long rows = 0;
+    for (long i = first; i < last; i++) {
+        double theta1, theta2;
+        unsigned int seed;
+        trajectory_setup(i, &theta1, &theta2, &seed);
+        rows += write_trajectory(out, theta1, theta2, seed);
+    }
+    if (fclose(out) != 0 || rename(tmp, path) != 0) return -1;
+
+    atomic_store(&batch_state[batch], BATCH_DONE);
+    manifest_append("done %ld %ld\n", batch, rows);
+    atomic_fetch_add(&shared->trajectories_done, last - first);
+    atomic_fetch_add(&shared->rows_done, rows);
+    atomic_fetch_add(&shared->batches_done, 1);
+    return 0;
+}
+
+// Function to take the next batch position from the front of a worker's own range; returns -1 when empty
+static int take_own(WorkerSlot *slot) {
+    uint64_t range = atomic_load(&slot->range);
+    for (;;) {
+        uint32_t head = (uint32_t)range, tail = (uint32_t)(range >> 32);
+        if (head >= tail) return -1;
+        if (atomic_compare_exchange_weak(&slot->range, &range, pack_range(head + 1, tail))) return head;
+    }
+}
+
+// Function to move the back half of another worker's range into the thief's own (empty) range
+static int steal(int thief, uint64_t *random_state) {
+    int workers = shared->workers;
+    int offset = (int)(next_random(random_state) % workers);
+    for (int k = 0; k < workers; k++) {
+        int victim = (offset + k) % workers;
+        if (victim == thief) continue;
+        WorkerSlot *slot = &shared->slots[victim];
+        uint64_t range = atomic_load(&slot->range);
+        for (;;) {
+            uint32_t head = (uint32_t)range, tail = (uint32_t)(range >> 32);
+            if (head >= tail) break;
+            uint32_t take = (tail - head + 1) / 2;
+            if (atomic_compare_exchange_weak(&slot->range, &range, pack_range(head, tail - take))) {
+                // Only the owner stores into its own range, and only while it is empty, so a plain store is safe
+                atomic_store(&shared->slots[thief].range, pack_range(tail - take, tail));
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Worker process: finish the batch a crashed predecessor left behind, then drain the own range and steal
+void worker_main(int worker) {
+    // Workers must not outlive the coordinator, or they would race a resumed job for the same shards
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid() != coordinator_pid) _exit(1);
+
+    WorkerSlot *slot = &shared->slots[worker];
+    uint64_t random_state = job.seed ^ ((uint64_t)getpid() << 20);
+
+    for (;;) {
+        int batch = atomic_load(&slot->current);
+        if (batch < 0) {
+            int position = take_own(slot);
+            if (position < 0) {
+                if (!steal(worker, &random_state)) break;
+                continue;
+            }
+            batch = pending[position];
+            atomic_store(&slot->current, batch);
+        }
+        if (atomic_load(&batch_state[batch]) == BATCH_PENDING && run_batch(batch) != 0) {
+            fprintf(stderr, "Worker %d: cannot write batch %d: %s\n", worker, batch, strerror(errno));
+            _exit(2);
+        }
+        atomic_store(&slot->current, -1);
+    }
+    _exit(0);
+}
+
+// Function to start (or restart) worker process w
+static int spawn_worker(int worker) {
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) worker_main(worker);
+    shared->slots[worker].pid = pid;
+    return 0;
+}
+
+// Function to read the job parameters and finished batches from an existing manifest; returns 0 if none exists
+int load_manifest(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) return 0;
+
+    char key[32];
+    int version = 0;
+    if (fscanf(file, "EXOGEN %d", &version) != 1 || version != MANIFEST_VERSION) {
+        fprintf(stderr, "Error: %s is not a version %d job manifest\n", path, MANIFEST_VERSION);
+        exit(1);
+    }
+    // Manifests written before the physics keys existed were generated with the default physics
+    Job loaded = job;
+    loaded.ground = GROUND_Y;
+    loaded.contact = 1;
+    loaded.mpc = 0;
+    while (fscanf(file, "%31s", key) == 1) {
+        long a = 0, b = 0;
+        if (strcmp(key, "trajectories") == 0) fscanf(file, "%ld", &loaded.trajectories);
+        else if (strcmp(key, "batch") == 0) fscanf(file, "%d", &loaded.batch_size);
+        else if (strcmp(key, "seed") == 0) fscanf(file, "%" SCNu64, &loaded.seed);
+        else if (strcmp(key, "spread") == 0) fscanf(file, "%lf", &loaded.spread);
+        else if (strcmp(key, "ground") == 0) fscanf(file, "%lf", &loaded.ground);
+        else if (strcmp(key, "contact") == 0) fscanf(file, "%d", &loaded.contact);
+        else if (strcmp(key, "mpc") == 0) fscanf(file, "%d", &loaded.mpc);
+        else if (strcmp(key, "done") == 0 || strcmp(key, "failed") == 0 || strcmp(key, "merged") == 0) {
+            fscanf(file, "%ld %ld", &a, &b);
+            if (key[0] == 'm') {
+                fclose(file);
+                return 2;
+            }
+            if (batch_state == NULL) {
+                // Parameters are complete once the first batch record appears
+                job = loaded;
+                batch_count = (int)((job.trajectories + job.batch_size - 1) / job.batch_size);
+                batch_state = calloc(batch_count, 1);
+                if (batch_state == NULL) exit(1);
+            }
+            if (a >= 0 && a < batch_count) {
+                char shard[4096];
+                shard_path(shard, sizeof(shard), (int)a, ".txt");
+                if (key[0] == 'f') batch_state[a] = BATCH_FAILED;
+                else if (access(shard, R_OK) == 0) batch_state[a] = BATCH_DONE;  // Redo shards lost after the record
+            }
+        }
+    }
+    job = loaded;
+    fclose(file);
+    return 1;
+}
+
+// Function to concatenate the finished shards into dataset.txt with one header, then remove them
+int merge_shards(int keep_shards) {
+    char tmp[4096], path[4096];
+    job_path(tmp, sizeof(tmp), "dataset.tmp");
+    job_path(path, sizeof(path), "dataset.txt");
+    FILE *out = fopen(tmp, "w");
+    if (out == NULL) return -1;
+    fprintf(out, "Prev_Theta1\tPrev_Theta2\tStart_Theta1\tStart_Theta2\tEnd_Theta1\tEnd_Theta2\tTorque1\tTorque2\n");
+
+    static char buffer[1 << 16];
+    long rows = 0;
+    for (int b = 0; b < batch_count; b++) {
+        if (atomic_load(&batch_state[b]) != BATCH_DONE) continue;
+        char shard[4096];
+        shard_path(shard, sizeof(shard), b, ".txt");
+        FILE *in = fopen(shard, "r");
+        if (in == NULL) {
+            fclose(out);
+            return -1;
+        }
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+            fwrite(buffer, 1, n, out);
+            for (size_t i = 0; i < n; i++) rows += buffer[i] == '\n';
+        }
+        fclose(in);
+    }
+    if (fclose(out) != 0 || rename(tmp, path) != 0) return -1;
+    manifest_append("merged %ld %ld\n", rows, 0);
+
+    for (int b = 0; b < batch_count; b++) {
+        char shard[4096];
+        shard_path(shard, sizeof(shard), b, ".tmp");  // Left by crashed workers
+        unlink(shard);
+        if (!keep_shards) {
+            shard_path(shard, sizeof(shard), b, ".txt");
+            unlink(shard);
+        }
+    }
+    printf("Wrote %s (%ld rows)\n", path, rows);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int workers = 0, keep_shards = 0;
+    Job requested = job;
+    int explicit_params = 0;
+    for (int i = 1; i < argc; i++) {
+        int has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--job") == 0 && has_value) job_dir = argv[++i];
+        else if (strcmp(argv[i], "--workers") == 0 && has_value) workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--keep-shards") == 0) keep_shards = 1;
+        else if (strcmp(argv[i], "--trajectories") == 0 && has_value) {
+            requested.trajectories = atol(argv[++i]);
+            explicit_params = 1;
+        } else if (strcmp(argv[i], "--batch") == 0 && has_value) {
+            requested.batch_size = atoi(argv[++i]);
+            explicit_params = 1;
+        } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+            requested.seed = strtoull(argv[++i], NULL, 10);
+            explicit_params = 1;
+        } else if (strcmp(argv[i], "--spread") == 0 && has_value) {
+            requested.spread = atof(argv[++i]);
+            explicit_params = 1;
+        } else if (strcmp(argv[i], "--ground") == 0 && has_value) {
+            requested.ground = atof(argv[++i]);
+            explicit_params = 1;
+        } else if (strcmp(argv[i], "--no-contact") == 0) {
+            requested.contact = 0;
+            explicit_params = 1;
+        } else if (strcmp(argv[i], "--mpc") == 0) {
+            requested.mpc = 1;
+            explicit_params = 1;
+        } else {
+            job_dir = NULL;
+            break;
+        }
+    }
+    if (job_dir == NULL) {
+        fprintf(stderr, "Usage: %s --job DIR [--trajectories N] [--batch B] [--seed S] [--spread RAD] "
+                        "[--mpc] [--ground Y | --no-contact] [--workers W] [--keep-shards]\n", argv[0]);
+        return 1;
+    }
+    if (workers <= 0) workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers <= 0) workers = 1;
+    if (workers > MAX_WORKERS) workers = MAX_WORKERS;
+    if (requested.trajectories <= 0 || requested.batch_size <= 0) {
+        fprintf(stderr, "Error: --trajectories and --batch must be positive\n");
+        return 1;
+    }
+
+    // Resume the job in DIR if it has a manifest, otherwise start a new one
+    char manifest[4096];
+    if (mkdir(job_dir, 0777) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Error: cannot create %s: %s\n", job_dir, strerror(errno));
+        return 1;
+    }
+    job_path(manifest, sizeof(manifest), "manifest.txt");
+    job = requested;
+    int resumed = load_manifest(manifest);
+    if (resumed == 2) {
+        printf("Job %s is already complete.\n", job_dir);
+        return 0;
+    }
+    if (resumed && explicit_params &&
+        (job.trajectories != requested.trajectories || job.batch_size != requested.batch_size ||
+         job.seed != requested.seed || job.spread != requested.spread || job.ground != requested.ground ||
+         job.contact != requested.contact || job.mpc != requested.mpc)) {
+        fprintf(stderr, "Warning: resuming %s with the parameters from its manifest\n", job_dir);
+    }
+    batch_count = (int)((job.trajectories + job.batch_size - 1) / job.batch_size);
+    ground_y = job.ground;
+    use_contact = job.contact;
+
+    manifest_fd = open(manifest, O_WRONLY | O_APPEND | O_CREAT, 0666);
+    if (manifest_fd < 0) {
+        fprintf(stderr, "Error: cannot open %s: %s\n", manifest, strerror(errno));
+        return 1;
+    }
+    if (!resumed) {
+        char header[256];
+        int length = snprintf(header, sizeof(header),
+                              "EXOGEN %d\ntrajectories %ld\nbatch %d\nseed %" PRIu64 "\nspread %.17g\n"
+                              "ground %.17g\ncontact %d\nmpc %d\n",
+                              MANIFEST_VERSION, job.trajectories, job.batch_size, job.seed, job.spread,
+                              job.ground, job.contact, job.mpc);
+        if (write(manifest_fd, header, length) != length) {
+            fprintf(stderr, "Error: cannot write %s\n", manifest);
+            return 1;
+        }
+    }
+
+    // Shared memory: control block, batch states and the pending array
+    size_t state_offset = (sizeof(Shared) + 63) & ~(size_t)63;
+    size_t pending_offset = (state_offset + batch_count + 63) & ~(size_t)63;
+    size_t size = pending_offset + sizeof(int) * (size_t)batch_count;
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        fprintf(stderr, "Error: out of memory\n");
+        return 1;
+    }
+    shared = memory;
+    shared->workers = workers;
+    _Atomic unsigned char *states = (_Atomic unsigned char *)((char *)memory + state_offset);
+    for (int b = 0; b < batch_count; b++) states[b] = batch_state != NULL ? batch_state[b] : BATCH_PENDING;
+    free((void *)batch_state);
+    batch_state = states;
+    pending = (int *)((char *)memory + pending_offset);
+
+    int *attempts = calloc(batch_count, sizeof(int));
+    int idle_crashes[MAX_WORKERS] = { 0 };
+    int restarts = 0, failed = 0, already = 0;
+    for (int b = 0; b < batch_count; b++) already += batch_state[b] != BATCH_PENDING;
+    if (resumed) printf("Resuming %s: %d of %d batches already finished\n", job_dir, already, batch_count);
+
+    coordinator_pid = getpid();
+    double start = now_seconds(), last_report = 0.0;
+    signal(SIGPIPE, SIG_IGN);
+
+    // Rounds: split the pending batches into one contiguous range per worker and run until every worker is done.
+    // A batch lost by a crash at an unlucky moment is still pending afterwards and goes into the next round.
+    for (;;) {
+        int count = 0;
+        for (int b = 0; b < batch_count; b++) {
+            if (batch_state[b] == BATCH_PENDING) pending[count++] = b;
+        }
+        if (count == 0) break;
+
+        for (int w = 0; w < workers; w++) {
+            uint32_t head = (uint32_t)((long)count * w / workers);
+            uint32_t tail = (uint32_t)((long)count * (w + 1) / workers);
+            atomic_store(&shared->slots[w].range, pack_range(head, tail));
+            atomic_store(&shared->slots[w].current, -1);
+        }
+        fflush(stdout);
+        int running = 0;
+        for (int w = 0; w < workers; w++) {
+            if (idle_crashes[w] >= MAX_WORKER_CRASHES) continue;  // Its range is stolen by the others
+            if (spawn_worker(w) != 0) {
+                fprintf(stderr, "Error: cannot start worker %d: %s\n", w, strerror(errno));
+                return 1;
+            }
+            running++;
+        }
+        if (running == 0) {
+            fprintf(stderr, "Error: every worker keeps crashing outside a batch; %d batches left, rerun to resume\n",
+                    count);
+            return 1;
+        }
+
+        while (running > 0) {
+            int status;
+            pid_t pid = waitpid(-1, &status, WNOHANG);
+            if (pid == 0) {
+                struct timespec pause = { 0, 100000000 };
+                nanosleep(&pause, NULL);
+            } else if (pid > 0) {
+                int w = 0;
+                while (w < workers && shared->slots[w].pid != pid) w++;
+                if (w == workers) continue;
+                if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                    running--;
+                } else {
+                    // Crash: charge the batch in progress and give up on it after MAX_ATTEMPTS. A crash outside
+                    // any batch is charged to the worker, which is not restarted after MAX_WORKER_CRASHES of them.
+                    int batch = atomic_load(&shared->slots[w].current);
+                    int retire = batch < 0 && ++idle_crashes[w] >= MAX_WORKER_CRASHES;
+                    fprintf(stderr, "\nWorker %d (pid %d) %s %d during batch %d; %s\n", w, (int)pid,
+                            WIFSIGNALED(status) ? "killed by signal" : "exited with",
+                            WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status), batch,
+                            retire ? "not restarting it" : "restarting");
+                    if (batch >= 0 && ++attempts[batch] >= MAX_ATTEMPTS) {
+                        batch_state[batch] = BATCH_FAILED;
+                        atomic_store(&shared->slots[w].current, -1);
+                        manifest_append("failed %ld %ld\n", batch, attempts[batch]);
+                        failed++;
+                    }
+                    if (retire) {
+                        running--;
+                    } else if (spawn_worker(w) != 0) {
+                        fprintf(stderr, "Error: cannot restart worker %d: %s\n", w, strerror(errno));
+                        running--;
+                    } else {
+                        restarts++;
+                    }
+                }
+            } else if (errno != EINTR) {
+                break;
+            }
+
+            double now = now_seconds();
+            if (now - last_report >= 1.0 || running == 0) {
+                int done = atomic_load(&shared->batches_done);
+                double rate = atomic_load(&shared->trajectories_done) / (now - start);
+                double eta = rate > 0.0 ? (batch_count - already - done - failed) * (double)job.batch_size / rate : 0.0;
+                fprintf(stderr, "\r%d/%d batches, %ld rows, %.0f trajectories/s, ETA %.0f s, %d restarts   ",
+                        already + done, batch_count, atomic_load(&shared->rows_done), rate, eta, restarts);
+                last_report = now;
+            }
+        }
+    }
+    fprintf(stderr, "\n");
+
+    double elapsed = now_seconds() - start;
+    printf("Generated %ld trajectories (%ld rows) in %.1f s with %d workers; %d restarts, %d failed batches\n",
+           atomic_load(&shared->trajectories_done), atomic_load(&shared->rows_done), elapsed, workers, restarts, failed);
+    if (failed > 0) {
+        printf("Failed batches are recorded in %s; dataset.txt leaves them out\n", manifest);
+    }
+    return merge_shards(keep_shards) == 0 ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+import math
+
+# This document is Licensed under Creative Commons CC0.
+# To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+# to this document to the public domain worldwide.
+# This document is distributed without any warranty.
+# You should have received a copy of the CC0 Public Domain Dedication along with this document.
+# If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+# Leg physics for the Python controllers: compute_gravitational_torques() and simulate_step().
+#
+# They come from the C core (physics.h via exophysics.c) when the module is built; the pure Python
+# copies below are only a fallback, with the same default ground contact.
+
+# Constants (same as in physics.h)
+G = 9.81       # Gravity (m/s²)
+L1 = 1.0       # Length of first rod (m)
+L2 = 1.5       # Length of second rod (m)
+M1 = 1.0       # Mass of first rod (kg)
+M2 = 1.5       # Mass of second rod (kg)
+DT = 0.01      # Time step (s)
+
+try:
+    from exophysics import compute_gravitational_torques, simulate_step
+except ImportError:
+    # Function to compute gravitational torque for each joint
+    def compute_gravitational_torques(theta1, theta2):
+        # Gravitational torque on first rod (negative when rod is at positive angle)
+        tau1 = -M1 * G * L1 * math.sin(theta1) - M2 * G * L1 * math.sin(theta1)
+        # Gravitational torque on second rod (negative when rod is at positive angle)
+        tau2 = -M2 * G * L2 * math.sin(theta2)
+        return tau1, tau2
+
+    # Ground contact at the ankle, as in physics.h (y up from the hip, the leg hangs down at θ = 0)
+    GROUND_Y = 0.02 - (L1 + L2)  # 2 cm above the foot of the fully extended leg (m)
+    CONTACT_K = 5000.0           # Penalty stiffness (N/m)
+    CONTACT_C = 80.0             # Penalty damping (N·s/m)
+    CONTACT_MU = 0.8             # Coulomb friction coefficient
+    CONTACT_VEPS = 0.01          # Slip velocity below which friction is regularized (m/s)
+
+    # Function to compute joint torques from the foot-ground contact force
+    def compute_contact_torques(theta1, omega1, theta2, omega2):
+        s1, c1 = math.sin(theta1), math.cos(theta1)
+        s12, c12 = math.sin(theta1 + theta2), math.cos(theta1 + theta2)
+        # Ankle height and the Jacobian of the ankle position with respect to (θ1, θ2)
+        y = -(L1 * c1 + L2 * c12)
+        jx1, jx2 = L1 * c1 + L2 * c12, L2 * c12
+        jy1, jy2 = L1 * s1 + L2 * s12, L2 * s12
+        depth = GROUND_Y - y
+        if depth <= 0.0:
+            return 0.0, 0.0
+        vx = jx1 * omega1 + jx2 * omega2
+        vy = jy1 * omega1 + jy2 * omega2
+        fy = max(0.0, CONTACT_K * depth - CONTACT_C * vy)
+        fx = -CONTACT_MU * fy * vx / (abs(vx) + CONTACT_VEPS)
+        # τ = Jᵀ F
+        return jx1 * fx + jy1 * fy, jx2 * fx + jy2 * fy
+
+    # Function to simulate one time step
+    def simulate_step(theta1, omega1, theta2, omega2, tau1, tau2):
+        # Ground reaction from the current state adds to the applied torques
+        contact_tau1, contact_tau2 = compute_contact_torques(theta1, omega1, theta2, omega2)
+        tau1 += contact_tau1
+        tau2 += contact_tau2
+
+        # Angular accelerations (τ = Iα, I = mL² for each rod)
+        alpha1 = tau1 / (M1 * L1 * L1)  # First joint
+        alpha2 = tau2 / (M2 * L2 * L2)  # Second joint
+
+        # Update angular velocities and angles
+        omega1 += alpha1 * DT
+        omega2 += alpha2 * DT
+        theta1 += omega1 * DT
+        theta2 += omega2 * DT
+
+        return theta1, omega1, theta2, omega2
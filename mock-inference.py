@@ -0,0 +1,172 @@
+import re
+import sys
+import json
+import time
+import random
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from torque_prompt import HEADER, KEY_COLUMNS
+
+# This document is Licensed under Creative Commons CC0.
+# To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+# to this document to the public domain worldwide.
+# This document is distributed without any warranty.
+# You should have received a copy of the CC0 Public Domain Dedication along with this document.
+# If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+# Offline stand-in for an OpenAI-compatible chat completions endpoint (Cerebras, OpenRouter).
+#
+# Any POST to a path ending in /chat/completions is answered, streamed as server-sent events or as
+# one JSON body depending on "stream". The first token is sent after the configured time-to-first-
+# token and the rest at the configured token rate, so the controllers and robot-control-bench.py see
+# the timing of a real service without a network or an API key.
+#
+# Answers come from a script file, one per line, used in turn. "\n" in a line stands for a newline and
+# {nearest} for the torques of the first candidate row of a torque_prompt.py question, which makes the
+# mock a perfect matcher. Without a script every answer is "{nearest}".
+#
+# Usage: python mock-inference.py [--port 8000] [--ttft-ms 0] [--tokens-per-second 0 (unlimited)]
+#                                 [--jitter-ms 0] [--script FILE]
+
+# Roughly how LLM tokenizers split text: words, runs of up to three digits, single symbols, spaces
+TOKEN_PATTERN = re.compile(r' ?[A-Za-z]+|\d{1,3}|\s+|[^\sA-Za-z\d]')
+
+# Function to split text into tokens as sent in the stream
+def split_tokens(text):
+    return TOKEN_PATTERN.findall(text)
+
+# Function to fill an answer template from the question
+def render_answer(template, question):
+    if "{nearest}" in template:
+        lines = question.split("\n")
+        torques = "0.00 0.00"
+        if HEADER in lines:
+            row = lines.index(HEADER) + 1
+            if row < len(lines):
+                torques = " ".join(f"{float(v):.2f}" for v in lines[row].split()[KEY_COLUMNS:KEY_COLUMNS + 2])
+        template = template.replace("{nearest}", torques)
+    return template
+
+class MockHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"   # Keep-alive, like the pooled connections of the real clients
+    disable_nagle_algorithm = True  # Each token leaves at once instead of waiting for the previous one's ACK
+    settings = {}
+    answers = ["{nearest}"]
+    counter = 0
+
+    def log_message(self, format, *args):
+        pass
+
+    # Function to send a JSON body
+    def send_json(self, status, body):
+        data = json.dumps(body).encode()
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+    # Function to send one server-sent event as an HTTP chunk
+    def send_event(self, text):
+        data = f"data: {text}\n\n".encode()
+        self.wfile.write(f"{len(data):x}\r\n".encode() + data + b"\r\n")
+        self.wfile.flush()
+
+    # The Cerebras client warms its connection up with a GET; anything that is not a completion gets an empty object
+    def do_GET(self):
+        self.send_json(200, {})
+
+    def do_POST(self):
+        received = time.perf_counter()
+        body = self.rfile.read(int(self.headers.get("Content-Length", 0)))
+        if not self.path.endswith("/chat/completions"):
+            self.send_json(404, {"error": {"message": f"Unknown path {self.path}"}})
+            return
+        try:
+            request = json.loads(body)
+            question = request["messages"][-1]["content"]
+        except (ValueError, KeyError, IndexError, TypeError):
+            self.send_json(400, {"error": {"message": "Malformed chat completion request"}})
+            return
+
+        cls = type(self)
+        template = cls.answers[cls.counter % len(cls.answers)]
+        cls.counter += 1
+        answer = render_answer(template, question)
+        tokens = split_tokens(answer)
+        usage = {
+            "prompt_tokens": sum(len(split_tokens(m.get("content", ""))) for m in request["messages"]),
+            "completion_tokens": len(tokens)
+        }
+        usage["total_tokens"] = usage["prompt_tokens"] + usage["completion_tokens"]
+        completion_id = f"chatcmpl-mock-{cls.counter}"
+        model = request.get("model", "mock")
+
+        # Time to first token, then one token every 1 / rate seconds, both measured from the request
+        ttft = (self.settings["ttft_ms"] + random.uniform(0.0, self.settings["jitter_ms"])) / 1000.0
+        rate = self.settings["tokens_per_second"]
+        due = [received + ttft + (i / rate if rate > 0 else 0.0) for i in range(len(tokens))]
+
+        if not request.get("stream"):
+            if due:
+                time.sleep(max(0.0, due[-1] - time.perf_counter()))
+            self.send_json(200, {
+                "id": completion_id, "object": "chat.completion", "created": int(time.time()), "model": model,
+                "choices": [{"index": 0, "message": {"role": "assistant", "content": answer},
+                             "finish_reason": "stop"}],
+                "usage": usage
+            })
+            return
+
+        self.send_response(200)
+        self.send_header("Content-Type", "text/event-stream")
+        self.send_header("Transfer-Encoding", "chunked")
+        self.end_headers()
+
+        # Function to make a completion chunk with the given delta
+        def chunk(delta, finish_reason=None, with_usage=False):
+            event = {
+                "id": completion_id, "object": "chat.completion.chunk", "created": int(time.time()), "model": model,
+                "choices": [{"index": 0, "delta": delta, "finish_reason": finish_reason}]
+            }
+            if with_usage:
+                event["usage"] = usage
+            return json.dumps(event)
+
+        self.send_event(chunk({"role": "assistant", "content": ""}))
+        for token, at in zip(tokens, due):
+            time.sleep(max(0.0, at - time.perf_counter()))
+            self.send_event(chunk({"content": token}))
+        self.send_event(chunk({}, "stop", True))
+        self.send_event("[DONE]")
+        self.wfile.write(b"0\r\n\r\n")
+        self.wfile.flush()
+
+# Function to read an answer script: one answer per line, "\n" for a newline
+def read_script(path):
+    with open(path, "r", encoding="utf-8") as file:
+        answers = [line.rstrip("\r\n").replace("\\n", "\n") for line in file]
+    return [a for a in answers if a] or ["{nearest}"]
+
+# Function to read an option value from the command line
+def option(name, default):
+    return type(default)(sys.argv[sys.argv.index(name) + 1]) if name in sys.argv else default
+
+# Main function
+if __name__ == "__main__":
+    port = option("--port", 8000)
+    MockHandler.settings = {
+        "ttft_ms": option("--ttft-ms", 0.0),
+        "tokens_per_second": option("--tokens-per-second", 0.0),
+        "jitter_ms": option("--jitter-ms", 0.0)
+    }
+    if "--script" in sys.argv:
+        MockHandler.answers = read_script(option("--script", ""))
+
+    server = ThreadingHTTPServer(("127.0.0.1", port), MockHandler)
+    print(f"Mock chat completions on http://127.0.0.1:{port}/v1 "
+          f"(TTFT {MockHandler.settings['ttft_ms']} ms, {MockHandler.settings['tokens_per_second'] or 'unlimited'} "
+          f"tokens/s, {len(MockHandler.answers)} scripted answers)", flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,520 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "physics.h"
+
+// This document is Licensed under Creative Commons CC0.
+// To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+// to this document to the public domain worldwide.
+// This document is distributed without any warranty.
+// You should have received a copy of the CC0 Public Domain Dedication along with this document.
+// If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+/*
+gcc -O2 montecarlo.c -o montecarlo -lm -lpthread; ./montecarlo --rollouts 1000000 > robustness.txt
+*/
+
+// Monte Carlo robustness analysis of the leg from simulation.c.
+// Every rollout draws its own masses, lengths, PD gains and control noise amplitude around the nominal
+// values and runs the full 10 s trajectory through the physics.h step, ground contact included (the ground
+// stays at its height below the hip while the rod lengths vary). Nothing per rollout is stored: worker threads take fixed chunks
+// of rollouts and fold each chunk's samples into its own streaming reducers (Welford mean/variance, t-digest
+// quantiles, event counters) per recorded time step. Finished chunks are merged into the total in chunk
+// order, so the output is the same for any thread count, and memory is independent of the rollout count.
+
+// Nominal parameters are leg_nominal from physics.h
+#define NOISE 0.1    // Control torque noise amplitude (±10%, as in compute_control_torques())
+
+// Analysis constants
+#define MAX_STEPS 1000           // 10 seconds, as in simulation.c
+#define FAIL_ANGLE (M_PI / 2)    // A rod past horizontal counts as a fall
+#define SETTLE_TOL 0.01          // Convergence check from simulate_arm()
+#define SETTLE_WINDOW 10         // Steps the settle check averages the joint speeds over (0.1 s)
+#define MOTOR_MARGIN 1.5         // Motor strength relative to the horizontal holding torque (exoskeleton.e)
+#define QUANTITIES 4             // Theta1, Theta2, Torque1, Torque2
+#define TD_COMPRESSION 100.0     // t-digest compression (roughly the number of centroids kept)
+#define TD_CAPACITY 256
+#define TD_BUFFER 512
+#define CHUNK_ROLLOUTS 4096      // Rollouts per unit of work; results do not depend on the thread count
+
+// Streaming mean/variance (Welford), mergeable with Chan's formula
+typedef struct {
+    double n;
+    double mean;
+    double m2;
+} Welford;
+
+typedef struct {
+    double mean;
+    double weight;
+} Centroid;
+
+// Merging t-digest: sorted centroids plus a buffer of unmerged samples
+typedef struct {
+    Centroid c[TD_CAPACITY];
+    int n;
+    Centroid buf[TD_BUFFER];
+    int nbuf;
+    double total;
+    double min;
+    double max;
+} TDigest;
+
+// Reducers for one recorded time step
+typedef struct {
+    Welford moments[QUANTITIES];
+    TDigest digest[QUANTITIES];
+    double saturated;   // Rollouts whose torque demand exceeds a motor limit at this step
+    double failed;      // Rollouts that have fallen by this step
+    double unsettled;   // Rollouts that have not yet met the convergence check
+} StepStats;
+
+// Reducers for one chunk of rollouts (and, after merging, for the whole run)
+typedef struct {
+    StepStats *steps;
+    TDigest settle_time;
+    Welford settle_moments;
+    double rollouts;
+    double failures;        // Fell, or never settled within MAX_STEPS
+} Reducers;
+
+// Physical and controller parameters of one rollout
+typedef struct {
+    LegParams leg;
+    double noise;
+} RolloutParams;
+
+// Run configuration
+int rollouts = 100000;
+int threads = 0;
+int every = 10;              // Record reducers every this many steps
+double spread = 0.1;         // Relative half-width of the parameter distributions
+uint64_t seed = 1;
+double start_theta1 = M_PI / 6;
+double start_theta2 = M_PI / 6;
+
+// Function to advance a splitmix64 generator
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Function to draw a uniform number in [-1, 1)
+static double uniform_pm1(uint64_t *state) {
+    return (next_random(state) >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+}
+
+// Function to add one sample to a Welford accumulator
+static void welford_add(Welford *w, double x) {
+    w->n += 1.0;
+    double delta = x - w->mean;
+    w->mean += delta / w->n;
+    w->m2 += delta * (x - w->mean);
+}
+
+// Function to merge Welford accumulator b into a
+static void welford_merge(Welford *a, const Welford *b) {
+    if (b->n == 0.0) return;
+    double n = a->n + b->n;
+    double delta = b->mean - a->mean;
+    a->mean += delta * b->n / n;
+    a->m2 += b->m2 + delta * delta * a->n * b->n / n;
+    a->n = n;
+}
+
+// Function to read the sample standard deviation of a Welford accumulator
+static double welford_std(const Welford *w) {
+    return w->n > 1.0 ? sqrt(w->m2 / (w->n - 1.0)) : 0.0;
+}
+
+static void td_init(TDigest *td) {
+    td->n = 0;
+    td->nbuf = 0;
+    td->total = 0.0;
+    td->min = INFINITY;
+    td->max = -INFINITY;
+}
+
+// Function to map a quantile to the t-digest k1 scale
+static double td_k(double q) {
+    return TD_COMPRESSION / (2.0 * M_PI) * asin(2.0 * q - 1.0);
+}
+
+// Function to map a k1 scale value back to a quantile
+static double td_q(double k) {
+    return (sin(k * 2.0 * M_PI / TD_COMPRESSION) + 1.0) / 2.0;
+}
+
+static int compare_centroids(const void *a, const void *b) {
+    double x = ((const Centroid *)a)->mean, y = ((const Centroid *)b)->mean;
+    return (x > y) - (x < y);
+}
+
+// Function to fold the buffered samples into the centroid list
+static void td_compress(TDigest *td) {
+    if (td->nbuf == 0) return;
+
+    Centroid all[TD_CAPACITY + TD_BUFFER];
+    int count = td->n + td->nbuf;
+    memcpy(all, td->c, sizeof(Centroid) * td->n);
+    memcpy(all + td->n, td->buf, sizeof(Centroid) * td->nbuf);
+    qsort(all, count, sizeof(Centroid), compare_centroids);
+
+    double total = 0.0;
+    for (int i = 0; i < count; i++) total += all[i].weight;
+
+    // Greedily merge neighbours while the merged centroid stays within one unit of the k scale
+    int n = 0;
+    double so_far = 0.0;
+    double q_limit = td_q(td_k(0.0) + 1.0) * total;
+    Centroid cur = all[0];
+    for (int i = 1; i < count; i++) {
+        if ((so_far + cur.weight + all[i].weight <= q_limit) || n == TD_CAPACITY - 1) {
+            cur.mean += (all[i].mean - cur.mean) * all[i].weight / (cur.weight + all[i].weight);
+            cur.weight += all[i].weight;
+        } else {
+            so_far += cur.weight;
+            td->c[n++] = cur;
+            q_limit = td_q(td_k(so_far / total) + 1.0) * total;
+            cur = all[i];
+        }
+    }
+    td->c[n++] = cur;
+    td->n = n;
+    td->nbuf = 0;
+    td->total = total;
+}
+
+// Function to add one weighted sample to a t-digest
+static void td_add_weighted(TDigest *td, double x, double weight) {
+    if (td->nbuf == TD_BUFFER) td_compress(td);
+    td->buf[td->nbuf].mean = x;
+    td->buf[td->nbuf].weight = weight;
+    td->nbuf++;
+    if (x < td->min) td->min = x;
+    if (x > td->max) td->max = x;
+}
+
+static void td_add(TDigest *td, double x) {
+    td_add_weighted(td, x, 1.0);
+}
+
+// Function to merge t-digest b into a
+static void td_merge(TDigest *a, TDigest *b) {
+    td_compress(b);
+    for (int i = 0; i < b->n; i++) td_add_weighted(a, b->c[i].mean, b->c[i].weight);
+    if (b->min < a->min) a->min = b->min;
+    if (b->max > a->max) a->max = b->max;
+}
+
+// Function to estimate quantile q by interpolating between centroid centers
+static double td_quantile(TDigest *td, double q) {
+    td_compress(td);
+    if (td->n == 0) return NAN;
+    if (td->n == 1) return td->c[0].mean;
+
+    double target = q * td->total;
+    double cumulative = td->c[0].weight / 2.0;
+    if (target <= cumulative) {
+        return td->min + (td->c[0].mean - td->min) * (cumulative > 0.0 ? target / cumulative : 0.0);
+    }
+    for (int i = 1; i < td->n; i++) {
+        double next = cumulative + (td->c[i - 1].weight + td->c[i].weight) / 2.0;
+        if (target <= next) {
+            double t = (target - cumulative) / (next - cumulative);
+            return td->c[i - 1].mean + t * (td->c[i].mean - td->c[i - 1].mean);
+        }
+        cumulative = next;
+    }
+    double last_half = td->c[td->n - 1].weight / 2.0;
+    double t = last_half > 0.0 ? (target - cumulative) / last_half : 1.0;
+    return td->c[td->n - 1].mean + (t > 1.0 ? 1.0 : t) * (td->max - td->c[td->n - 1].mean);
+}
+
+// Function to add the PD control torques with noise drawn from the rollout's own generator
+static void compute_control_torques_noisy(const RolloutParams *p, uint64_t *rng, double theta1, double omega1,
+                                          double theta2, double omega2, double *tau1, double *tau2) {
+    double noise_factor1 = 1.0 + p->noise * uniform_pm1(rng);
+    double noise_factor2 = 1.0 + p->noise * uniform_pm1(rng);
+    leg_control_torques(&p->leg, theta1, omega1, theta2, omega2, noise_factor1, noise_factor2, tau1, tau2);
+}
+
+// Function to tell whether the ankle of a leg is on or below the ground
+static int standing(const LegParams *p, double theta1, double theta2) {
+    return use_contact && -(p->l1 * cos(theta1) + p->l2 * cos(theta1 + theta2)) <= ground_y;
+}
+
+// Function to draw the parameters of one rollout around the nominal design
+static void draw_params(RolloutParams *p, uint64_t *rng) {
+    p->leg.m1 = leg_nominal.m1 * (1.0 + spread * uniform_pm1(rng));
+    p->leg.m2 = leg_nominal.m2 * (1.0 + spread * uniform_pm1(rng));
+    p->leg.l1 = leg_nominal.l1 * (1.0 + spread * uniform_pm1(rng));
+    p->leg.l2 = leg_nominal.l2 * (1.0 + spread * uniform_pm1(rng));
+    p->leg.kp1 = leg_nominal.kp1 * (1.0 + spread * uniform_pm1(rng));
+    p->leg.kd1 = leg_nominal.kd1 * (1.0 + spread * uniform_pm1(rng));
+    p->leg.kp2 = leg_nominal.kp2 * (1.0 + spread * uniform_pm1(rng));
+    p->leg.kd2 = leg_nominal.kd2 * (1.0 + spread * uniform_pm1(rng));
+    p->noise = NOISE * (1.0 + spread * uniform_pm1(rng));
+}
+
+static int recorded_steps() {
+    return (MAX_STEPS + every - 1) / every;
+}
+
+static Reducers *reducers_create() {
+    Reducers *r = calloc(1, sizeof(Reducers));
+    if (r == NULL) return NULL;
+    r->steps = calloc(recorded_steps(), sizeof(StepStats));
+    if (r->steps == NULL) {
+        free(r);
+        return NULL;
+    }
+    for (int s = 0; s < recorded_steps(); s++) {
+        for (int q = 0; q < QUANTITIES; q++) td_init(&r->steps[s].digest[q]);
+    }
+    td_init(&r->settle_time);
+    return r;
+}
+
+static void reducers_free(Reducers *r) {
+    if (r == NULL) return;
+    free(r->steps);
+    free(r);
+}
+
+// Function to merge reducers b into a
+static void reducers_merge(Reducers *a, Reducers *b) {
+    for (int s = 0; s < recorded_steps(); s++) {
+        StepStats *x = &a->steps[s], *y = &b->steps[s];
+        for (int q = 0; q < QUANTITIES; q++) {
+            welford_merge(&x->moments[q], &y->moments[q]);
+            td_merge(&x->digest[q], &y->digest[q]);
+        }
+        x->saturated += y->saturated;
+        x->failed += y->failed;
+        x->unsettled += y->unsettled;
+    }
+    td_merge(&a->settle_time, &b->settle_time);
+    welford_merge(&a->settle_moments, &b->settle_moments);
+    a->rollouts += b->rollouts;
+    a->failures += b->failures;
+}
+
+// Function to run one rollout and fold it into the reducers.
+// In stance the stiff contact makes the joint speeds chatter around zero from one step to the next while the pose
+// holds still, so the settle check averages the speeds over SETTLE_WINDOW steps, and a leg at rest counts as
+// settled either at the target pose or standing on the ground.
+static void run_rollout(Reducers *r, uint64_t index) {
+    uint64_t rng = seed * 0x2545f4914f6cdd1dULL ^ index;
+    next_random(&rng);
+
+    RolloutParams p;
+    draw_params(&p, &rng);
+
+    // Motor limits: 150% of the torque that holds both rods horizontal
+    double limit1 = MOTOR_MARGIN * (p.leg.m1 + p.leg.m2) * G * p.leg.l1;
+    double limit2 = MOTOR_MARGIN * p.leg.m2 * G * p.leg.l2;
+
+    double theta1 = start_theta1, omega1 = 0.0;
+    double theta2 = start_theta2, omega2 = 0.0;
+    double past1[SETTLE_WINDOW], past2[SETTLE_WINDOW];   // Angles of the last SETTLE_WINDOW steps
+    for (int k = 0; k < SETTLE_WINDOW; k++) {
+        past1[k] = theta1;
+        past2[k] = theta2;
+    }
+    int settled_at = -1, fallen = 0;
+
+    for (int i = 0; i < MAX_STEPS; i++) {
+        double tau1 = 0.0, tau2 = 0.0;
+        leg_gravitational_torques(&p.leg, theta1, theta2, &tau1, &tau2);
+        compute_control_torques_noisy(&p, &rng, theta1, omega1, theta2, omega2, &tau1, &tau2);
+        leg_simulate_step(&p.leg, &theta1, &omega1, &theta2, &omega2, tau1, tau2);
+
+        if (fabs(theta1) > FAIL_ANGLE || fabs(theta2) > FAIL_ANGLE) fallen = 1;
+        double speed1 = fabs(theta1 - past1[i % SETTLE_WINDOW]) / (SETTLE_WINDOW * DT);
+        double speed2 = fabs(theta2 - past2[i % SETTLE_WINDOW]) / (SETTLE_WINDOW * DT);
+        past1[i % SETTLE_WINDOW] = theta1;
+        past2[i % SETTLE_WINDOW] = theta2;
+        if (settled_at < 0 && speed1 < SETTLE_TOL && speed2 < SETTLE_TOL &&
+            ((fabs(theta1) < SETTLE_TOL && fabs(theta2) < SETTLE_TOL) || standing(&p.leg, theta1, theta2))) {
+            settled_at = i;
+        }
+
+        if (i % every == 0) {
+            StepStats *s = &r->steps[i / every];
+            double values[QUANTITIES] = { theta1, theta2, tau1, tau2 };
+            for (int q = 0; q < QUANTITIES; q++) {
+                welford_add(&s->moments[q], values[q]);
+                td_add(&s->digest[q], values[q]);
+            }
+            s->saturated += (fabs(tau1) > limit1 || fabs(tau2) > limit2);
+            s->failed += fallen;
+            s->unsettled += (settled_at < 0);
+        }
+    }
+
+    r->rollouts += 1.0;
+    if (fallen || settled_at < 0) {
+        r->failures += 1.0;
+    } else {
+        td_add(&r->settle_time, (settled_at + 1) * DT);
+        welford_add(&r->settle_moments, (settled_at + 1) * DT);
+    }
+}
+
+// Work shared by the threads: rollouts in fixed chunks, each reduced on its own and merged in chunk order
+typedef struct {
+    pthread_mutex_t lock;
+    int chunks;
+    int next_chunk;         // Next chunk to claim
+    int next_merge;         // Next chunk to fold into total
+    Reducers **finished;    // Finished chunks waiting for their predecessors to be merged
+    Reducers *total;
+    int out_of_memory;
+} Schedule;
+
+// Function to claim chunks until none are left, merging finished ones into the total in chunk order
+static void *worker_main(void *arg) {
+    Schedule *w = arg;
+    for (;;) {
+        pthread_mutex_lock(&w->lock);
+        int chunk = w->out_of_memory ? w->chunks : w->next_chunk++;
+        pthread_mutex_unlock(&w->lock);
+        if (chunk >= w->chunks) break;
+
+        Reducers *r = reducers_create();
+        if (r == NULL) {
+            pthread_mutex_lock(&w->lock);
+            w->out_of_memory = 1;
+            pthread_mutex_unlock(&w->lock);
+            break;
+        }
+        uint64_t end = (uint64_t)(chunk + 1) * CHUNK_ROLLOUTS;
+        if (end > (uint64_t)rollouts) end = rollouts;
+        for (uint64_t i = (uint64_t)chunk * CHUNK_ROLLOUTS; i < end; i++) {
+            run_rollout(r, i);
+        }
+
+        // The t-digests depend on merge order, so the total sees the same sequence for any thread count
+        pthread_mutex_lock(&w->lock);
+        w->finished[chunk] = r;
+        while (w->next_merge < w->chunks && w->finished[w->next_merge] != NULL) {
+            reducers_merge(w->total, w->finished[w->next_merge]);
+            reducers_free(w->finished[w->next_merge]);
+            w->finished[w->next_merge++] = NULL;
+        }
+        pthread_mutex_unlock(&w->lock);
+    }
+    return NULL;
+}
+
+// Function to compute a 95% Wilson score interval for k successes in n trials
+static void wilson_interval(double k, double n, double *lo, double *hi) {
+    const double z = 1.959964;
+    double p = k / n, z2 = z * z / n;
+    double center = (p + z2 / 2.0) / (1.0 + z2);
+    double half = z * sqrt(p * (1.0 - p) / n + z * z / (4.0 * n * n)) / (1.0 + z2);
+    *lo = center - half < 0.0 ? 0.0 : center - half;
+    *hi = center + half > 1.0 ? 1.0 : center + half;
+}
+
+// Function to print the per-step table on stdout and the certification summary on stderr
+static void report(Reducers *r, double seconds) {
+    const char *names[QUANTITIES] = { "Theta1", "Theta2", "Torque1", "Torque2" };
+
+    printf("Step\tTime");
+    for (int q = 0; q < QUANTITIES; q++) {
+        printf("\t%s_Mean\t%s_Std\t%s_P05\t%s_P50\t%s_P95", names[q], names[q], names[q], names[q], names[q]);
+    }
+    printf("\tP_Saturated\tP_Failed\tP_Unsettled\n");
+
+    for (int s = 0; s < recorded_steps(); s++) {
+        StepStats *st = &r->steps[s];
+        printf("%d\t%.2f", s * every, (s * every + 1) * DT);
+        for (int q = 0; q < QUANTITIES; q++) {
+            printf("\t%.6f\t%.6f\t%.6f\t%.6f\t%.6f", st->moments[q].mean, welford_std(&st->moments[q]),
+                   td_quantile(&st->digest[q], 0.05), td_quantile(&st->digest[q], 0.5),
+                   td_quantile(&st->digest[q], 0.95));
+        }
+        printf("\t%.6f\t%.6f\t%.6f\n", st->saturated / r->rollouts, st->failed / r->rollouts,
+               st->unsettled / r->rollouts);
+    }
+
+    double lo, hi;
+    wilson_interval(r->failures, r->rollouts, &lo, &hi);
+    fprintf(stderr, "Rollouts: %.0f (%d threads, %.2f s, %.0f rollouts/s)\n",
+            r->rollouts, threads, seconds, r->rollouts / seconds);
+    fprintf(stderr, "Parameter spread: ±%.0f%%, start angles: %.4f %.4f rad\n",
+            spread * 100.0, start_theta1, start_theta2);
+    if (use_contact) fprintf(stderr, "Ground: %.3f m below the hip\n", -ground_y);
+    else fprintf(stderr, "Ground: none\n");
+    fprintf(stderr, "Failure probability (fell or unsettled after %.0f s): %.6f [95%% CI %.6f, %.6f]\n",
+            MAX_STEPS * DT, r->failures / r->rollouts, lo, hi);
+    if (r->settle_moments.n > 0) {
+        fprintf(stderr, "Settle time: mean %.3f s, std %.3f s, p50 %.3f s, p95 %.3f s, p99 %.3f s\n",
+                r->settle_moments.mean, welford_std(&r->settle_moments),
+                td_quantile(&r->settle_time, 0.5), td_quantile(&r->settle_time, 0.95),
+                td_quantile(&r->settle_time, 0.99));
+    }
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        int has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--rollouts") == 0 && has_value) rollouts = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && has_value) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--every") == 0 && has_value) every = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--spread") == 0 && has_value) spread = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && has_value) seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--ground") == 0 && has_value) ground_y = atof(argv[++i]);
+        else if (strcmp(argv[i], "--no-contact") == 0) use_contact = 0;
+        else if (strcmp(argv[i], "--start") == 0 && i + 2 < argc) {
+            start_theta1 = atof(argv[++i]);
+            start_theta2 = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--rollouts N] [--threads T] [--every K] [--spread S] [--seed X] "
+                            "[--start THETA1 THETA2] [--ground Y] [--no-contact]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+    if (every <= 0) every = 1;
+    if (rollouts <= 0) rollouts = 1;
+
+    Schedule work = { .chunks = (rollouts + CHUNK_ROLLOUTS - 1) / CHUNK_ROLLOUTS };
+    pthread_mutex_init(&work.lock, NULL);
+    work.finished = calloc(work.chunks, sizeof(Reducers *));
+    work.total = reducers_create();
+    pthread_t *ids = calloc(threads, sizeof(pthread_t));
+    if (work.finished == NULL || work.total == NULL || ids == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        return 1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    for (int t = 0; t < threads; t++) pthread_create(&ids[t], NULL, worker_main, &work);
+    for (int t = 0; t < threads; t++) pthread_join(ids[t], NULL);
+    if (work.out_of_memory) {
+        fprintf(stderr, "Error: out of memory\n");
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    report(work.total, (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+
+    reducers_free(work.total);
+    free(work.finished);
+    free(ids);
+    pthread_mutex_destroy(&work.lock);
+    return 0;
+}
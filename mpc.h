@@ -0,0 +1,331 @@
+#ifndef MPC_H
+#define MPC_H
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "physics.h"
+
+// This document is Licensed under Creative Commons CC0.
+// To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+// to this document to the public domain worldwide.
+// This document is distributed without any warranty.
+// You should have received a copy of the CC0 Public Domain Dedication along with this document.
+// If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+// Real-time iLQR model predictive controller over the physics.h step, shared by simulation.c and generate.c.
+// Header-only like physics.h: every function is static inline, and the workspace is one static instance per
+// program, so call mpc_reset() before each new trajectory.
+
+// Model predictive control (iLQR) constants
+#define MPC_HORIZON 50          // Prediction horizon in steps (0.5 s)
+#define MPC_MAX_ITERATIONS 8    // iLQR iterations per tick at most
+#define MPC_BUDGET_US 1000.0    // Solver time budget per tick (10% of DT)
+#define MPC_Q_THETA 400.0       // Stage cost weight on angles
+#define MPC_Q_OMEGA 20.0        // Stage cost weight on angular velocities
+#define MPC_R 0.01              // Stage cost weight on motor torques
+#define MPC_QF_SCALE 10.0       // Terminal cost relative to the stage cost
+#define MPC_MOTOR_MARGIN 1.5    // Motor strength relative to the horizontal holding torque (exoskeleton.e)
+#define MPC_FD_EPS 1e-6         // Finite difference step for linearizing the model
+#define MPC_DEADLINE_SLACK_US 50.0  // Longest stretch between deadline checks, not counted as an overrun
+
+// Preallocated iLQR workspace; the plan carries over between ticks as the warm start
+typedef struct {
+    double x[MPC_HORIZON + 1][4];   // Nominal states (theta1, omega1, theta2, omega2)
+    double u[MPC_HORIZON][2];       // Nominal motor torques
+    double x_new[MPC_HORIZON + 1][4];
+    double u_new[MPC_HORIZON][2];
+    double fx[MPC_HORIZON][4][4];   // Model Jacobians along the nominal trajectory
+    double fu[MPC_HORIZON][4][2];
+    double k[MPC_HORIZON][2];       // Feedforward corrections
+    double K[MPC_HORIZON][2][4];    // Feedback gains
+    double u_max[2];                // Motor limits
+    int warm;                       // Plan holds a solution from the previous tick
+    // Statistics for the run summary
+    int ticks;
+    int overruns;
+    int iterations;
+    double solve_us_total;
+    double solve_us_max;
+} MpcWorkspace;
+
+static MpcWorkspace mpc;
+
+// Function to read a monotonic clock in microseconds
+static inline double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Prediction model: one noise-free physics step with motor torques u on top of gravity
+static inline void mpc_model(const double x[4], const double u[2], double x_next[4]) {
+    double tau1 = 0.0, tau2 = 0.0;
+    compute_gravitational_torques(x[0], x[2], &tau1, &tau2);
+    x_next[0] = x[0]; x_next[1] = x[1]; x_next[2] = x[2]; x_next[3] = x[3];
+    simulate_step(&x_next[0], &x_next[1], &x_next[2], &x_next[3], tau1 + u[0], tau2 + u[1]);
+}
+
+// Function to compute the quadratic stage cost
+static inline double mpc_stage_cost(const double x[4], const double u[2]) {
+    return MPC_Q_THETA * (x[0] * x[0] + x[2] * x[2]) + MPC_Q_OMEGA * (x[1] * x[1] + x[3] * x[3]) +
+           MPC_R * (u[0] * u[0] + u[1] * u[1]);
+}
+
+static inline double mpc_final_cost(const double x[4]) {
+    double none[2] = { 0.0, 0.0 };
+    return MPC_QF_SCALE * mpc_stage_cost(x, none);
+}
+
+static inline double mpc_clamp(double v, double limit) {
+    return v > limit ? limit : (v < -limit ? -limit : v);
+}
+
+// Function to roll the nominal controls out from x0 and return the trajectory cost
+static inline double mpc_rollout(const double x0[4], double u[MPC_HORIZON][2], double x[MPC_HORIZON + 1][4]) {
+    double cost = 0.0;
+    for (int j = 0; j < 4; j++) x[0][j] = x0[j];
+    for (int i = 0; i < MPC_HORIZON; i++) {
+        mpc_model(x[i], u[i], x[i + 1]);
+        cost += mpc_stage_cost(x[i], u[i]);
+    }
+    return cost + mpc_final_cost(x[MPC_HORIZON]);
+}
+
+// Function to linearize the prediction model along the nominal trajectory by forward differences.
+// The nominal rollout already holds the unperturbed step, so each stage costs 6 model evaluations.
+// Returns 0 if the deadline passes first.
+static inline int mpc_linearize(double deadline) {
+    for (int i = 0; i < MPC_HORIZON; i++) {
+        if (now_us() >= deadline) return 0;
+        double xp[4], up[2], fp[4];
+        const double *f0 = mpc.x[i + 1];
+        for (int j = 0; j < 4; j++) {
+            for (int r = 0; r < 4; r++) xp[r] = mpc.x[i][r];
+            xp[j] += MPC_FD_EPS;
+            mpc_model(xp, mpc.u[i], fp);
+            for (int r = 0; r < 4; r++) mpc.fx[i][r][j] = (fp[r] - f0[r]) / MPC_FD_EPS;
+        }
+        for (int j = 0; j < 2; j++) {
+            up[0] = mpc.u[i][0];
+            up[1] = mpc.u[i][1];
+            up[j] += MPC_FD_EPS;
+            mpc_model(mpc.x[i], up, fp);
+            for (int r = 0; r < 4; r++) mpc.fu[i][r][j] = (fp[r] - f0[r]) / MPC_FD_EPS;
+        }
+    }
+    return 1;
+}
+
+static inline int mpc_backward(double mu) {
+    const double q[4] = { MPC_Q_THETA, MPC_Q_OMEGA, MPC_Q_THETA, MPC_Q_OMEGA };
+    double Vx[4], Vxx[4][4];
+
+    for (int r = 0; r < 4; r++) {
+        Vx[r] = 2.0 * MPC_QF_SCALE * q[r] * mpc.x[MPC_HORIZON][r];
+        for (int c = 0; c < 4; c++) Vxx[r][c] = r == c ? 2.0 * MPC_QF_SCALE * q[r] : 0.0;
+    }
+
+    for (int i = MPC_HORIZON - 1; i >= 0; i--) {
+        double (*A)[4] = mpc.fx[i], (*B)[2] = mpc.fu[i];
+        double Qx[4], Qu[2], Qxx[4][4], Quu[2][2], Qux[2][4], VA[4][4], VB[4][2];
+
+        // VA = Vxx A, VB = Vxx B
+        for (int r = 0; r < 4; r++) {
+            for (int c = 0; c < 4; c++) {
+                VA[r][c] = 0.0;
+                for (int m = 0; m < 4; m++) VA[r][c] += Vxx[r][m] * A[m][c];
+            }
+            for (int c = 0; c < 2; c++) {
+                VB[r][c] = 0.0;
+                for (int m = 0; m < 4; m++) VB[r][c] += Vxx[r][m] * B[m][c];
+            }
+        }
+        for (int r = 0; r < 4; r++) {
+            Qx[r] = 2.0 * q[r] * mpc.x[i][r];
+            for (int m = 0; m < 4; m++) Qx[r] += A[m][r] * Vx[m];
+            for (int c = 0; c < 4; c++) {
+                Qxx[r][c] = r == c ? 2.0 * q[r] : 0.0;
+                for (int m = 0; m < 4; m++) Qxx[r][c] += A[m][r] * VA[m][c];
+            }
+        }
+        for (int r = 0; r < 2; r++) {
+            Qu[r] = 2.0 * MPC_R * mpc.u[i][r];
+            for (int m = 0; m < 4; m++) Qu[r] += B[m][r] * Vx[m];
+            for (int c = 0; c < 2; c++) {
+                Quu[r][c] = r == c ? 2.0 * MPC_R + mu : 0.0;
+                for (int m = 0; m < 4; m++) Quu[r][c] += B[m][r] * VB[m][c];
+            }
+            for (int c = 0; c < 4; c++) {
+                Qux[r][c] = 0.0;
+                for (int m = 0; m < 4; m++) Qux[r][c] += B[m][r] * VA[m][c];
+            }
+        }
+
+        double det = Quu[0][0] * Quu[1][1] - Quu[0][1] * Quu[1][0];
+        if (Quu[0][0] <= 0.0 || det <= 0.0) return 0;
+        double inv[2][2] = { {  Quu[1][1] / det, -Quu[0][1] / det },
+                             { -Quu[1][0] / det,  Quu[0][0] / det } };
+
+        for (int r = 0; r < 2; r++) {
+            mpc.k[i][r] = -(inv[r][0] * Qu[0] + inv[r][1] * Qu[1]);
+            for (int c = 0; c < 4; c++) mpc.K[i][r][c] = -(inv[r][0] * Qux[0][c] + inv[r][1] * Qux[1][c]);
+            // A torque pinned at the motor limit gets no feedback that would push it further out
+            if (fabs(mpc.u[i][r]) >= mpc.u_max[r] && mpc.u[i][r] * mpc.k[i][r] > 0.0) {
+                mpc.k[i][r] = 0.0;
+                for (int c = 0; c < 4; c++) mpc.K[i][r][c] = 0.0;
+            }
+        }
+
+        // Vx = Qx + K^T Quu k + K^T Qu + Qux^T k, Vxx = Qxx + K^T Quu K + K^T Qux + Qux^T K
+        for (int r = 0; r < 4; r++) {
+            Vx[r] = Qx[r];
+            for (int a = 0; a < 2; a++) {
+                Vx[r] += mpc.K[i][a][r] * Qu[a] + Qux[a][r] * mpc.k[i][a];
+                for (int b = 0; b < 2; b++) Vx[r] += mpc.K[i][a][r] * Quu[a][b] * mpc.k[i][b];
+            }
+            for (int c = 0; c < 4; c++) {
+                double v = Qxx[r][c];
+                for (int a = 0; a < 2; a++) {
+                    v += mpc.K[i][a][r] * Qux[a][c] + Qux[a][r] * mpc.K[i][a][c];
+                    for (int b = 0; b < 2; b++) v += mpc.K[i][a][r] * Quu[a][b] * mpc.K[i][b][c];
+                }
+                Vxx[r][c] = v;
+            }
+        }
+        for (int r = 0; r < 4; r++) {
+            for (int c = r + 1; c < 4; c++) Vxx[r][c] = Vxx[c][r] = (Vxx[r][c] + Vxx[c][r]) / 2.0;
+        }
+    }
+    return 1;
+}
+
+// Function to apply the feedback policy with step size alpha; returns the new trajectory cost,
+// or NAN if the deadline passes first
+static inline double mpc_forward(double alpha, double deadline) {
+    double cost = 0.0;
+    for (int j = 0; j < 4; j++) mpc.x_new[0][j] = mpc.x[0][j];
+    for (int i = 0; i < MPC_HORIZON; i++) {
+        if (i % 10 == 0 && now_us() >= deadline) return NAN;
+        for (int r = 0; r < 2; r++) {
+            double u = mpc.u[i][r] + alpha * mpc.k[i][r];
+            for (int c = 0; c < 4; c++) u += mpc.K[i][r][c] * (mpc.x_new[i][c] - mpc.x[i][c]);
+            mpc.u_new[i][r] = mpc_clamp(u, mpc.u_max[r]);
+        }
+        mpc_model(mpc.x_new[i], mpc.u_new[i], mpc.x_new[i + 1]);
+        cost += mpc_stage_cost(mpc.x_new[i], mpc.u_new[i]);
+    }
+    return cost + mpc_final_cost(mpc.x_new[MPC_HORIZON]);
+}
+
+// Function to solve the MPC problem from the current state within the tick budget.
+// The deadline is checked inside every loop, so a tick ends within a few microseconds of the budget with the
+// best plan found so far. Returns 1 and the first motor torques of the plan, or 0 on overrun.
+static inline int mpc_solve(double theta1, double omega1, double theta2, double omega2, double *u1, double *u2) {
+    static const double alphas[] = { 1.0, 0.5, 0.25, 0.1, 0.03 };
+    double start = now_us();
+    double deadline = start + MPC_BUDGET_US;
+    double x0[4] = { theta1, omega1, theta2, omega2 };
+
+    // Warm start: shift last tick's plan by one step and repeat its final torque.
+    // Cold start: the noise-free PD torques along their own predicted trajectory, a usable plan before any iteration.
+    if (mpc.warm) {
+        memmove(mpc.u[0], mpc.u[1], sizeof(mpc.u[0]) * (MPC_HORIZON - 1));
+    } else {
+        mpc.u_max[0] = MPC_MOTOR_MARGIN * (M1 + M2) * G * L1;
+        mpc.u_max[1] = MPC_MOTOR_MARGIN * M2 * G * L2;
+        double x[4] = { theta1, omega1, theta2, omega2 };
+        for (int i = 0; i < MPC_HORIZON; i++) {
+            mpc.u[i][0] = mpc_clamp(-KP1 * x[0] - KD1 * x[1], mpc.u_max[0]);
+            mpc.u[i][1] = mpc_clamp(-KP2 * x[2] - KD2 * x[3], mpc.u_max[1]);
+            mpc_model(x, mpc.u[i], x);
+        }
+    }
+    double cost = mpc_rollout(x0, mpc.u, mpc.x);
+
+    // Linearize once per tick: the nominal trajectory moves little between iterations, and the
+    // forward pass still rolls out the full nonlinear model, so stale Jacobians only slow convergence
+    int accepted = 0, converged = 0, failed_searches = 0;
+    int linearized = mpc_linearize(deadline);
+    double mu = 1e-6;
+    for (int it = 0; linearized && it < MPC_MAX_ITERATIONS && !converged; it++) {
+        if (!mpc_backward(mu)) {
+            mu *= 10.0;
+            continue;
+        }
+        int improved = 0;
+        for (size_t a = 0; a < sizeof(alphas) / sizeof(alphas[0]); a++) {
+            double new_cost = mpc_forward(alphas[a], deadline);
+            if (isnan(new_cost) && now_us() >= deadline) break;
+            if (isfinite(new_cost) && new_cost < cost) {
+                double gain = cost - new_cost;
+                memcpy(mpc.x, mpc.x_new, sizeof(mpc.x));
+                memcpy(mpc.u, mpc.u_new, sizeof(mpc.u));
+                cost = new_cost;
+                improved = 1;
+                accepted++;
+                mpc.iterations++;
+                converged = gain < 1e-6 * cost;
+                break;
+            }
+        }
+        if (now_us() >= deadline) break;
+        if (improved) {
+            failed_searches = 0;
+        } else {
+            // Two failed line searches in a row mean the stale model has stopped helping (in stance
+            // the contact kinks it); keep what was accepted instead of burning the budget
+            mu *= 10.0;
+            if (mu > 1e6 || ++failed_searches == 2) break;
+        }
+    }
+
+    double elapsed = now_us() - start;
+    mpc.ticks++;
+    mpc.solve_us_total += elapsed;
+    if (elapsed > mpc.solve_us_max) mpc.solve_us_max = elapsed;
+
+    // Graceful fallback: a tick that still overran (e.g. preempted) hands over to PD and drops the warm start
+    if (elapsed > MPC_BUDGET_US + MPC_DEADLINE_SLACK_US) {
+        mpc.overruns++;
+        mpc.warm = 0;
+        return 0;
+    }
+    // Without an accepted iteration the shifted plan would run open loop; start the next tick cold instead
+    mpc.warm = accepted > 0;
+    *u1 = mpc.u[0][0];
+    *u2 = mpc.u[0][1];
+    return 1;
+}
+
+// Function to compute control torque with MPC, falling back to the PD controller on overrun
+static inline void compute_mpc_torques(double theta1, double omega1, double theta2, double omega2, double *tau1, double *tau2) {
+    double control_tau1, control_tau2;
+    if (!mpc_solve(theta1, omega1, theta2, omega2, &control_tau1, &control_tau2)) {
+        compute_control_torques(theta1, omega1, theta2, omega2, tau1, tau2);
+        return;
+    }
+
+    // Same ±10% actuator noise as the PD controller
+    double noise_factor1 = 1.0 + (PHYSICS_RAND() % 201 - 100) / 1000.0;
+    double noise_factor2 = 1.0 + (PHYSICS_RAND() % 201 - 100) / 1000.0;
+
+    *tau1 += control_tau1 * noise_factor1;
+    *tau2 += control_tau2 * noise_factor2;
+}
+
+// Function to drop the warm start, so the next tick plans from scratch (a new trajectory)
+static inline void mpc_reset(void) {
+    mpc.warm = 0;
+}
+
+// Function to print the solver statistics of the run to stderr
+static inline void mpc_print_summary(void) {
+    if (mpc.ticks == 0) return;
+    fprintf(stderr, "MPC: %d ticks, mean solve %.1f us, max %.1f us (budget %.0f us), "
+                    "%.2f iterations/tick, %d PD fallbacks\n",
+            mpc.ticks, mpc.solve_us_total / mpc.ticks, mpc.solve_us_max, MPC_BUDGET_US,
+            (double)mpc.iterations / mpc.ticks, mpc.overruns);
+}
+
+#endif
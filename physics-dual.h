@@ -0,0 +1,117 @@
+#ifndef PHYSICS_DUAL_H
+#define PHYSICS_DUAL_H
+
+#include "physics.h"
+
+// This document is Licensed under Creative Commons CC0.
+// To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+// to this document to the public domain worldwide.
+// This document is distributed without any warranty.
+// You should have received a copy of the CC0 Public Domain Dedication along with this document.
+// If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+// Differentiable versions of the physics.h step functions.
+// They follow physics.h formula for formula on dual numbers, with the PD gains and the rod masses read from
+// a DualParams instead of the constants, so a rollout gives the trajectory together with its sensitivities to
+// all six parameters. The control noise is drawn with PHYSICS_RAND() exactly as in physics.h and treated as a
+// constant: a seeded dual rollout follows the double one up to rounding.
+// Nothing derives these from physics.h, so any change there must be repeated here (and in rollout_cost_value() of
+// tune.c); ./tune --check compares both with a physics.h rollout and fails when they drift apart.
+
+// Parameters the derivatives are taken with respect to
+enum { PARAM_KP1, PARAM_KD1, PARAM_KP2, PARAM_KD2, PARAM_M1, PARAM_M2, PARAMS };
+
+#define DUAL_N PARAMS
+#include "dual.h"
+
+typedef struct {
+    Dual kp1, kd1, kp2, kd2;
+    Dual m1, m2;
+} DualParams;
+
+// Function to make the parameters inputs of the differentiation, in PARAM_* order
+static inline DualParams dual_params(const double values[PARAMS]) {
+    DualParams p;
+    p.kp1 = dual_var(values[PARAM_KP1], PARAM_KP1);
+    p.kd1 = dual_var(values[PARAM_KD1], PARAM_KD1);
+    p.kp2 = dual_var(values[PARAM_KP2], PARAM_KP2);
+    p.kd2 = dual_var(values[PARAM_KD2], PARAM_KD2);
+    p.m1 = dual_var(values[PARAM_M1], PARAM_M1);
+    p.m2 = dual_var(values[PARAM_M2], PARAM_M2);
+    return p;
+}
+
+// Function to compute gravitational torque for each joint
+static inline void dual_gravitational_torques(const DualParams *p, Dual theta1, Dual theta2, Dual *tau1, Dual *tau2) {
+    Dual sin1 = dual_sin(theta1);
+    // Second rod's mass affects first joint
+    *tau1 = dual_sub(dual_scale(dual_mul(p->m1, sin1), -G * L1), dual_scale(dual_mul(p->m2, sin1), G * L1));
+    *tau2 = dual_scale(dual_mul(p->m2, dual_sin(theta2)), -G * L2);
+}
+
+// Function to compute control torque using PD controller
+static inline void dual_control_torques(const DualParams *p, Dual theta1, Dual omega1, Dual theta2, Dual omega2,
+                                        Dual *tau1, Dual *tau2) {
+    Dual control_tau1 = dual_neg(dual_add(dual_mul(p->kp1, theta1), dual_mul(p->kd1, omega1)));
+    Dual control_tau2 = dual_neg(dual_add(dual_mul(p->kp2, theta2), dual_mul(p->kd2, omega2)));
+
+    // Same ±10% noise draws as compute_control_torques()
+    double noise_factor1 = 1.0 + (PHYSICS_RAND() % 201 - 100) / 1000.0;
+    double noise_factor2 = 1.0 + (PHYSICS_RAND() % 201 - 100) / 1000.0;
+
+    *tau1 = dual_add(*tau1, dual_scale(control_tau1, noise_factor1));
+    *tau2 = dual_add(*tau2, dual_scale(control_tau2, noise_factor2));
+}
+
+// Function to compute joint torques from the foot-ground contact force (see contact_torques_from_angles())
+static inline void dual_contact_torques(Dual theta1, Dual omega1, Dual theta2, Dual omega2, Dual *tau1, Dual *tau2) {
+    // Out of contact the force and all its derivatives are zero, so check the penetration on plain values first
+    if (ground_y + L1 * cos(theta1.v) + L2 * cos(theta1.v + theta2.v) <= 0.0) {
+        *tau1 = *tau2 = dual_const(0.0);
+        return;
+    }
+
+    Dual shin = dual_add(theta1, theta2);
+    Dual s1 = dual_sin(theta1), c1 = dual_cos(theta1);
+    Dual s12 = dual_sin(shin), c12 = dual_cos(shin);
+
+    // Ankle height and the Jacobian of the ankle position with respect to (θ1, θ2)
+    Dual jx1 = dual_add(dual_scale(c1, L1), dual_scale(c12, L2)), jx2 = dual_scale(c12, L2);
+    Dual jy1 = dual_add(dual_scale(s1, L1), dual_scale(s12, L2)), jy2 = dual_scale(s12, L2);
+    Dual y = dual_neg(jx1);
+    Dual vx = dual_add(dual_mul(jx1, omega1), dual_mul(jx2, omega2));
+    Dual vy = dual_add(dual_mul(jy1, omega1), dual_mul(jy2, omega2));
+
+    Dual depth = dual_shift(dual_neg(y), ground_y);
+    Dual fy = dual_max(dual_const(0.0), dual_sub(dual_scale(depth, CONTACT_K), dual_scale(vy, CONTACT_C)));
+    Dual slip = dual_shift(dual_abs(vx), CONTACT_VEPS);
+    Dual fx = dual_scale(dual_div(dual_mul(fy, vx), slip), -CONTACT_MU);
+
+    // τ = Jᵀ F
+    *tau1 = dual_add(dual_mul(jx1, fx), dual_mul(jy1, fy));
+    *tau2 = dual_add(dual_mul(jx2, fx), dual_mul(jy2, fy));
+}
+
+// Function to simulate one time step
+static inline void dual_simulate_step(const DualParams *p, Dual *theta1, Dual *omega1, Dual *theta2, Dual *omega2,
+                                      Dual tau1, Dual tau2) {
+    // Ground reaction from the current state adds to the applied torques
+    if (use_contact) {
+        Dual contact_tau1, contact_tau2;
+        dual_contact_torques(*theta1, *omega1, *theta2, *omega2, &contact_tau1, &contact_tau2);
+        tau1 = dual_add(tau1, contact_tau1);
+        tau2 = dual_add(tau2, contact_tau2);
+    }
+
+    // Angular accelerations (τ = Iα, I = mL² for each rod)
+    Dual alpha1 = dual_div(tau1, dual_scale(p->m1, L1 * L1));
+    Dual alpha2 = dual_div(tau2, dual_scale(p->m2, L2 * L2));
+
+    // Update angular velocities and angles
+    *omega1 = dual_add(*omega1, dual_scale(alpha1, DT));
+    *omega2 = dual_add(*omega2, dual_scale(alpha2, DT));
+    *theta1 = dual_add(*theta1, dual_scale(*omega1, DT));
+    *theta2 = dual_add(*theta2, dual_scale(*omega2, DT));
+}
+
+#endif
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "physics.h"
+
+// This document is Licensed under Creative Commons CC0.
+// To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+// to this document to the public domain worldwide.
+// This document is distributed without any warranty.
+// You should have received a copy of the CC0 Public Domain Dedication along with this document.
+// If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+/*
+gcc -O2 physics-test.c -o physics-test -lm; ./physics-test
+*/
+
+// Ground contact test of physics.h.
+// Checks the direction of the contact torques, that the default simulation.c rollout actually reaches a
+// stance phase with bounded loads, and that the batched torques match the single-leg ones.
+// Exits non-zero if a check fails.
+
+#define STEPS 1000          // 10 s, as in simulation.c
+#define MAX_CONTACT 200.0   // Bound on the contact torque magnitude in a PD rollout (Nm)
+#define BATCH_LEGS 1000     // Legs in the batch comparison: several blocks, the first ones all in swing
+
+static int failures = 0;
+
+static void check(int ok, const char *what) {
+    printf("%-64s %s\n", what, ok ? "ok" : "FAIL");
+    failures += !ok;
+}
+
+// Function to run simulation.c's PD rollout; returns the number of steps with a non-zero contact torque
+static int rollout(double theta1, double theta2, unsigned int seed, double *max_contact) {
+    double omega1 = 0.0, omega2 = 0.0;
+    int in_contact = 0;
+    srand(seed);
+    *max_contact = 0.0;
+    for (int i = 0; i < STEPS; i++) {
+        double contact_tau1, contact_tau2;
+        compute_contact_torques(theta1, omega1, theta2, omega2, &contact_tau1, &contact_tau2);
+        if (contact_tau1 != 0.0 || contact_tau2 != 0.0) in_contact++;
+        *max_contact = fmax(*max_contact, fmax(fabs(contact_tau1), fabs(contact_tau2)));
+
+        double tau1 = 0.0, tau2 = 0.0;
+        compute_gravitational_torques(theta1, theta2, &tau1, &tau2);
+        compute_control_torques(theta1, omega1, theta2, omega2, &tau1, &tau2);
+        simulate_step(&theta1, &omega1, &theta2, &omega2, tau1, tau2);
+    }
+    return in_contact;
+}
+
+// Function to return the largest difference between compute_external_torques_batch() and the single-leg
+// gravity and contact torques over a spread of poses and velocities
+static double batch_torque_error() {
+    static double theta1[BATCH_LEGS], omega1[BATCH_LEGS], theta2[BATCH_LEGS], omega2[BATCH_LEGS];
+    static double tau1[BATCH_LEGS], tau2[BATCH_LEGS];
+    for (int i = 0; i < BATCH_LEGS; i++) {
+        // From folded (all of the first blocks above the ground) to hanging straight down, moving either way
+        theta1[i] = 1.2 * (1.0 - (double)i / BATCH_LEGS);
+        theta2[i] = -0.5 * theta1[i];
+        omega1[i] = (i % 7 - 3) * 0.4;
+        omega2[i] = (i % 5 - 2) * 0.6;
+    }
+    compute_external_torques_batch(BATCH_LEGS, theta1, omega1, theta2, omega2, tau1, tau2);
+
+    double error = 0.0;
+    for (int i = 0; i < BATCH_LEGS; i++) {
+        double ref1, ref2, contact_tau1, contact_tau2;
+        compute_gravitational_torques(theta1[i], theta2[i], &ref1, &ref2);
+        compute_contact_torques(theta1[i], omega1[i], theta2[i], omega2[i], &contact_tau1, &contact_tau2);
+        error = fmax(error, fmax(fabs(tau1[i] - ref1 - contact_tau1), fabs(tau2[i] - ref2 - contact_tau2)));
+    }
+    return error;
+}
+
+int main() {
+    double tau1, tau2, max_contact;
+
+    // The hanging leg reaches down to -(L1 + L2); the default ground is just above that
+    check(GROUND_Y > -(L1 + L2) && GROUND_Y < -(L1 + L2) + 0.1, "default ground just above the extended foot");
+
+    // A foot pushed into the ground is pushed back out: turning θ1 further raises it, so τ1 has the sign of θ1
+    compute_contact_torques(0.05, 0.0, 0.0, 0.0, &tau1, &tau2);
+    check(tau1 > 0.0 && tau2 > 0.0, "penetrating foot at theta1 > 0 is turned further out");
+    compute_contact_torques(-0.05, 0.0, 0.0, 0.0, &tau1, &tau2);
+    check(tau1 < 0.0 && tau2 < 0.0, "penetrating foot at theta1 < 0 is turned further out");
+
+    // A folded leg keeps its foot well above the default ground
+    compute_contact_torques(M_PI / 6, 0.0, M_PI / 6, 0.0, &tau1, &tau2);
+    check(tau1 == 0.0 && tau2 == 0.0, "no contact from the 30/30 degree start pose");
+
+    // The default rollout swings down into stance and stays there with bounded loads
+    int steps = rollout(M_PI / 6, M_PI / 6, 1, &max_contact);
+    printf("Default rollout: %d of %d steps in contact, max contact torque %.1f Nm\n", steps, STEPS, max_contact);
+    check(steps > STEPS / 2, "default rollout spends most of its steps in stance");
+    check(max_contact < MAX_CONTACT, "contact torques stay bounded");
+
+    // The batched torques share their sines between gravity and contact and skip blocks in swing
+    check(batch_torque_error() < 1e-9, "batched gravity and contact torques match the single-leg ones");
+
+    // A ground below the extended foot is never touched
+    ground_y = -(L1 + L2) - 0.01;
+    steps = rollout(M_PI / 6, M_PI / 6, 1, &max_contact);
+    check(steps == 0, "ground below full extension is never touched");
+    ground_y = GROUND_Y;
+
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures ? 1 : 0;
+}
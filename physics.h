@@ -0,0 +1,279 @@
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include <math.h>
+#include <stdlib.h>
+#include "vecmath.h"
+
+// This document is Licensed under Creative Commons CC0.
+// To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+// to this document to the public domain worldwide.
+// This document is distributed without any warranty.
+// You should have received a copy of the CC0 Public Domain Dedication along with this document.
+// If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+// Physics of the two-rod leg, shared by simulation.c, view.c and the exophysics Python module.
+// Header-only: every function is static inline, so each program compiles its own copy.
+// The single-leg functions call libm; the batched ones use the vecmath.h sin/cos kernels.
+
+// Constants
+#define G 9.81       // Gravity (m/s²)
+#define L1 1.0       // Length of first rod (m)
+#define L2 1.5       // Length of second rod (m)
+#define M1 1.0       // Mass of first rod (kg)
+#define M2 1.5       // Mass of second rod (kg)
+#define DT 0.01      // Time step (s)
+#define KP1 50.0     // Proportional gain for joint 1
+#define KD1 20.0     // Derivative gain for joint 1
+#define KP2 50.0     // Proportional gain for joint 2
+#define KD2 20.0     // Derivative gain for joint 2
+
+// Physical and controller parameters of one leg, for callers that vary them (montecarlo.c)
+typedef struct {
+    double m1, m2, l1, l2;
+    double kp1, kd1, kp2, kd2;
+} LegParams;
+
+// The design values above; the functions without a LegParams argument use these
+static const LegParams leg_nominal = { M1, M2, L1, L2, KP1, KD1, KP2, KD2 };
+
+// Source of the controller noise; define before including this header to replace rand()
+#ifndef PHYSICS_RAND
+#define PHYSICS_RAND() rand()
+#endif
+
+// Function to compute gravitational torque for each joint of a leg with the given parameters
+static inline void leg_gravitational_torques(const LegParams *p, double theta1, double theta2,
+                                             double *tau1, double *tau2) {
+    // Gravitational torque on first rod (negative when rod is at positive angle)
+    *tau1 = -p->m1 * G * p->l1 * sin(theta1) - p->m2 * G * p->l1 * sin(theta1); // Second rod's mass affects first joint
+    // Gravitational torque on second rod (negative when rod is at positive angle)
+    *tau2 = -p->m2 * G * p->l2 * sin(theta2);
+}
+
+// Function to compute gravitational torque for each joint
+static inline void compute_gravitational_torques(double theta1, double theta2, double *tau1, double *tau2) {
+    leg_gravitational_torques(&leg_nominal, theta1, theta2, tau1, tau2);
+}
+
+// Function to add the PD control torques of a leg with the given parameters, scaled by the given noise factors
+static inline void leg_control_torques(const LegParams *p, double theta1, double omega1, double theta2, double omega2,
+                                       double noise_factor1, double noise_factor2, double *tau1, double *tau2) {
+    // Error-correcting torques (negative feedback for stability)
+    double control_tau1 = -p->kp1 * theta1 - p->kd1 * omega1;
+    double control_tau2 = -p->kp2 * theta2 - p->kd2 * omega2;
+
+    control_tau1 *= noise_factor1;
+    control_tau2 *= noise_factor2;
+
+    // Add control torque to gravitational torque
+    *tau1 += control_tau1;
+    *tau2 += control_tau2;
+}
+
+// Function to compute control torque using PD controller
+static inline void compute_control_torques(double theta1, double omega1, double theta2, double omega2, double *tau1, double *tau2) {
+    // Add random noise of ±10% to simulate real-world conditions
+    double noise_factor1 = 1.0 + (PHYSICS_RAND() % 201 - 100) / 1000.0; // Range: 0.9 to 1.1
+    double noise_factor2 = 1.0 + (PHYSICS_RAND() % 201 - 100) / 1000.0; // Range: 0.9 to 1.1
+
+    leg_control_torques(&leg_nominal, theta1, omega1, theta2, omega2, noise_factor1, noise_factor2, tau1, tau2);
+}
+
+// Ground contact at the end of link 2 (the ankle in view.c)
+#define GROUND_Y (0.02 - (L1 + L2)) // Default ground height relative to the hip, y up (m): 2 cm above the foot
+                                     // of the fully extended leg, so the leg loads the ground near θ = 0
+#define CONTACT_K 5000.0    // Penalty stiffness (N/m)
+#define CONTACT_C 80.0      // Penalty damping (N·s/m)
+#define CONTACT_MU 0.8      // Coulomb friction coefficient
+#define CONTACT_VEPS 0.01   // Slip velocity below which friction is regularized (m/s)
+
+static double ground_y = GROUND_Y;
+static int use_contact = 1;
+
+// Function to compute joint torques from the foot-ground contact force, given sin/cos of θ1 and θ1+θ2.
+// θ = 0 hangs straight down, so with y up the ankle sits at L1·(sin θ1, -cos θ1) + L2·(sin(θ1+θ2), -cos(θ1+θ2))
+// from the hip.
+// The normal force is a spring-damper on the penetration depth and friction is Coulomb, smoothed around zero
+// slip as v / (|v| + ε). Everything is branch-free and free of libm calls (sqrt() would carry an errno check),
+// so batched loops over legs vectorize.
+static inline void leg_contact_torques_from_angles(const LegParams *p, double s1, double c1, double s12, double c12,
+                                                   double omega1, double omega2, double *tau1, double *tau2) {
+    // Ankle height and the Jacobian of the ankle position with respect to (θ1, θ2)
+    double y = -(p->l1 * c1 + p->l2 * c12);
+    double jx1 = p->l1 * c1 + p->l2 * c12, jx2 = p->l2 * c12;
+    double jy1 = p->l1 * s1 + p->l2 * s12, jy2 = p->l2 * s12;
+    double vx = jx1 * omega1 + jx2 * omega2;
+    double vy = jy1 * omega1 + jy2 * omega2;
+
+    double depth = ground_y - y;
+    double fy = CONTACT_K * depth - CONTACT_C * vy;
+    fy = depth > 0.0 && fy > 0.0 ? fy : 0.0;
+    double fx = -CONTACT_MU * fy * vx / (fabs(vx) + CONTACT_VEPS);
+
+    // τ = Jᵀ F
+    *tau1 = jx1 * fx + jy1 * fy;
+    *tau2 = jx2 * fx + jy2 * fy;
+}
+
+// Function to compute contact torques of the nominal leg from sin/cos of θ1 and θ1+θ2
+static inline void contact_torques_from_angles(double s1, double c1, double s12, double c12,
+                                               double omega1, double omega2, double *tau1, double *tau2) {
+    leg_contact_torques_from_angles(&leg_nominal, s1, c1, s12, c12, omega1, omega2, tau1, tau2);
+}
+
+// Function to compute joint torques from the foot-ground contact force for one leg with the given parameters
+static inline void leg_contact_torques(const LegParams *p, double theta1, double omega1, double theta2, double omega2,
+                                       double *tau1, double *tau2) {
+    leg_contact_torques_from_angles(p, sin(theta1), cos(theta1), sin(theta1 + theta2), cos(theta1 + theta2),
+                                    omega1, omega2, tau1, tau2);
+}
+
+// Function to compute joint torques from the foot-ground contact force for one leg
+static inline void compute_contact_torques(double theta1, double omega1, double theta2, double omega2,
+                                           double *tau1, double *tau2) {
+    leg_contact_torques(&leg_nominal, theta1, omega1, theta2, omega2, tau1, tau2);
+}
+
+// Function to simulate one time step of a leg with the given parameters
+static inline void leg_simulate_step(const LegParams *p, double *theta1, double *omega1, double *theta2, double *omega2,
+                                     double tau1, double tau2) {
+    // Ground reaction from the current state adds to the applied torques
+    if (use_contact) {
+        double contact_tau1, contact_tau2;
+        leg_contact_torques(p, *theta1, *omega1, *theta2, *omega2, &contact_tau1, &contact_tau2);
+        tau1 += contact_tau1;
+        tau2 += contact_tau2;
+    }
+
+    // Angular accelerations (τ = Iα, I = mL² for each rod)
+    double alpha1 = (tau1) / (p->m1 * p->l1 * p->l1); // First joint
+    double alpha2 = (tau2) / (p->m2 * p->l2 * p->l2); // Second joint
+
+    // Update angular velocities and angles
+    *omega1 += alpha1 * DT;
+    *omega2 += alpha2 * DT;
+    *theta1 += *omega1 * DT;
+    *theta2 += *omega2 * DT;
+}
+
+// Function to simulate one time step
+static inline void simulate_step(double *theta1, double *omega1, double *theta2, double *omega2, double tau1, double tau2) {
+    leg_simulate_step(&leg_nominal, theta1, omega1, theta2, omega2, tau1, tau2);
+}
+
+// Legs per block in the batched functions; keeps their sin/cos scratch arrays in L1 cache
+#define PHYSICS_BLOCK 256
+
+// Function to compute gravitational torques for n legs stored as arrays
+static inline void compute_gravitational_torques_batch(int n, const double *theta1, const double *theta2,
+                                                       double *tau1, double *tau2) {
+    vec_sin(n, theta1, tau1);
+    vec_sin(n, theta2, tau2);
+    for (int i = 0; i < n; i++) {
+        tau1[i] = -M1 * G * L1 * tau1[i] - M2 * G * L1 * tau1[i];
+        tau2[i] = -M2 * G * L2 * tau2[i];
+    }
+}
+
+// Function to compute knee and ankle positions for n legs, in the contact convention: hip at the origin, y up,
+// the leg hanging down at θ = 0 (knee at L1·(sin θ1, -cos θ1)). Screens whose y grows downward flip y when drawing.
+static inline void forward_kinematics_batch(int n, const double *theta1, const double *theta2,
+                                            double *knee_x, double *knee_y, double *ankle_x, double *ankle_y) {
+    double shin[PHYSICS_BLOCK], s12[PHYSICS_BLOCK], c12[PHYSICS_BLOCK];
+    for (int start = 0; start < n; start += PHYSICS_BLOCK) {
+        int count = n - start < PHYSICS_BLOCK ? n - start : PHYSICS_BLOCK;
+        for (int i = 0; i < count; i++) shin[i] = theta1[start + i] + theta2[start + i];
+        vec_sincos(count, theta1 + start, knee_x + start, knee_y + start);
+        vec_sincos(count, shin, s12, c12);
+        for (int i = 0; i < count; i++) {
+            knee_x[start + i] *= L1;
+            knee_y[start + i] *= -L1;
+            ankle_x[start + i] = knee_x[start + i] + L2 * s12[i];
+            ankle_y[start + i] = knee_y[start + i] - L2 * c12[i];
+        }
+    }
+}
+
+// Function to compute gravitational plus (when use_contact is set) ground contact torques for n legs.
+// Contact needs sin/cos of θ1 and θ1+θ2, and sin θ2 = sin(θ1+θ2)·cos θ1 - cos(θ1+θ2)·sin θ1, so gravity and
+// contact share two sincos passes per block. Blocks in which no ankle is below the ground skip the contact math.
+static inline void compute_external_torques_batch(int n, const double *restrict theta1, const double *restrict omega1,
+                                                  const double *restrict theta2, const double *restrict omega2,
+                                                  double *restrict tau1, double *restrict tau2) {
+    if (!use_contact) {
+        compute_gravitational_torques_batch(n, theta1, theta2, tau1, tau2);
+        return;
+    }
+    double shin[PHYSICS_BLOCK], s1[PHYSICS_BLOCK], c1[PHYSICS_BLOCK], s12[PHYSICS_BLOCK], c12[PHYSICS_BLOCK];
+    for (int start = 0; start < n; start += PHYSICS_BLOCK) {
+        int count = n - start < PHYSICS_BLOCK ? n - start : PHYSICS_BLOCK;
+        for (int i = 0; i < count; i++) shin[i] = theta1[start + i] + theta2[start + i];
+        vec_sincos(count, theta1 + start, s1, c1);
+        vec_sincos(count, shin, s12, c12);
+
+        int below = 0;
+        for (int i = 0; i < count; i++) {
+            int k = start + i;
+            double s2 = s12[i] * c1[i] - c12[i] * s1[i];
+            tau1[k] = -M1 * G * L1 * s1[i] - M2 * G * L1 * s1[i];
+            tau2[k] = -M2 * G * L2 * s2;
+            below += -(L1 * c1[i] + L2 * c12[i]) < ground_y;
+        }
+        if (below == 0) continue; // Every ankle of the block is at or above the ground
+
+        for (int i = 0; i < count; i++) {
+            int k = start + i;
+            double contact_tau1, contact_tau2;
+            contact_torques_from_angles(s1[i], c1[i], s12[i], c12[i], omega1[k], omega2[k],
+                                        &contact_tau1, &contact_tau2);
+            tau1[k] += contact_tau1;
+            tau2[k] += contact_tau2;
+        }
+    }
+}
+
+// Function to integrate one time step for n legs whose torques already hold every external force
+// (compute_external_torques_batch() plus control); no allocation, vectorizable
+static inline void integrate_step_batch(int n, double *restrict theta1, double *restrict omega1,
+                                        double *restrict theta2, double *restrict omega2,
+                                        const double *restrict tau1, const double *restrict tau2) {
+    for (int i = 0; i < n; i++) {
+        omega1[i] += tau1[i] / (M1 * L1 * L1) * DT;
+        omega2[i] += tau2[i] / (M2 * L2 * L2) * DT;
+        theta1[i] += omega1[i] * DT;
+        theta2[i] += omega2[i] * DT;
+    }
+}
+
+// Function to simulate one time step for n legs stored as arrays, adding the ground reaction to the given torques
+// like simulate_step() does. Loops that also compute gravity should use compute_external_torques_batch() and
+// integrate_step_batch() instead, which share the sines and cosines.
+static inline void simulate_step_batch(int n, double *restrict theta1, double *restrict omega1,
+                                       double *restrict theta2, double *restrict omega2,
+                                       const double *restrict tau1, const double *restrict tau2) {
+    if (use_contact) {
+        // The contact sines/cosines come from the SIMD kernels a block at a time, so the update loop has no calls
+        double shin[PHYSICS_BLOCK], s1[PHYSICS_BLOCK], c1[PHYSICS_BLOCK], s12[PHYSICS_BLOCK], c12[PHYSICS_BLOCK];
+        for (int start = 0; start < n; start += PHYSICS_BLOCK) {
+            int count = n - start < PHYSICS_BLOCK ? n - start : PHYSICS_BLOCK;
+            for (int i = 0; i < count; i++) shin[i] = theta1[start + i] + theta2[start + i];
+            vec_sincos(count, theta1 + start, s1, c1);
+            vec_sincos(count, shin, s12, c12);
+            for (int i = 0; i < count; i++) {
+                int k = start + i;
+                double contact_tau1, contact_tau2;
+                contact_torques_from_angles(s1[i], c1[i], s12[i], c12[i], omega1[k], omega2[k],
+                                            &contact_tau1, &contact_tau2);
+                omega1[k] += (tau1[k] + contact_tau1) / (M1 * L1 * L1) * DT;
+                omega2[k] += (tau2[k] + contact_tau2) / (M2 * L2 * L2) * DT;
+                theta1[k] += omega1[k] * DT;
+                theta2[k] += omega2[k] * DT;
+            }
+        }
+    } else {
+        integrate_step_batch(n, theta1, omega1, theta2, omega2, tau1, tau2);
+    }
+}
+
+#endif
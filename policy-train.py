@@ -0,0 +1,190 @@
+import os
+import sys
+import struct
+import argparse
+import subprocess
+import numpy as np
+
+# This document is Licensed under Creative Commons CC0.
+# To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+# to this document to the public domain worldwide.
+# This document is distributed without any warranty.
+# You should have received a copy of the CC0 Public Domain Dedication along with this document.
+# If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+# Offline trainer for the neural torque policy evaluated by policy.c.
+# Fits a small ReLU MLP mapping the six theta columns of the simulation output to (Torque1, Torque2).
+#
+#   python policy-train.py robot-control.txt -o policy.bin
+#   python policy-train.py --generate 200 -o policy.bin     # 200 trajectories from exophysics or ./simulation
+
+POLICY_MAGIC = b"EXOP"
+POLICY_VERSION = 1  # Must match policy.c
+INPUTS = 6
+OUTPUTS = 2
+MAX_LAYERS = 4   # POLICY_MAX_LAYERS in policy.c: dense layers, the output layer included
+MAX_WIDTH = 256  # POLICY_MAX_WIDTH in policy.c
+
+# Function to parse rows in the robot-control.txt format into inputs and targets
+def parse_rows(text):
+    rows = []
+    for line in text.splitlines():
+        values = line.strip().split('\t')
+        if len(values) < INPUTS + OUTPUTS:
+            continue
+        try:
+            rows.append([float(v) for v in values[:INPUTS + OUTPUTS]])
+        except ValueError:
+            continue  # Header line
+    data = np.array(rows, dtype=np.float64).reshape(-1, INPUTS + OUTPUTS)
+    return data[:, :INPUTS], data[:, INPUTS:]
+
+# Function to collect training data from files and/or fresh simulation runs
+def load_training_data(paths, generate, simulation):
+    xs, ys = [], []
+    for path in paths:
+        with open(path, "r", encoding="utf-8") as file:
+            x, y = parse_rows(file.read())
+        xs.append(x)
+        ys.append(y)
+    rng = np.random.default_rng()
+    try:
+        import exophysics
+    except ImportError:
+        exophysics = None
+    if generate and exophysics is not None:
+        # Same trajectories as ./simulation, generated in-process by the C core
+        starts = rng.uniform(-0.6, 0.6, size=(2, generate))
+        out = np.empty((generate * 1000, INPUTS + OUTPUTS))
+        rows = exophysics.generate_dataset(out, starts[0], starts[1], seed=int(rng.integers(1, 2**63)))
+        xs.append(out[:rows, :INPUTS])
+        ys.append(out[:rows, INPUTS:])
+        generate = 0
+    for _ in range(generate):
+        # Spread the start angles so the policy sees more than the default 30° trajectory
+        theta1, theta2 = rng.uniform(-0.6, 0.6, size=2)
+        command = [simulation, f"{theta1:.6f}", f"{theta2:.6f}", str(rng.integers(1, 2**31))]
+        output = subprocess.run(command, capture_output=True, text=True, check=True).stdout
+        x, y = parse_rows(output)
+        xs.append(x)
+        ys.append(y)
+    if not xs:
+        return np.zeros((0, INPUTS)), np.zeros((0, OUTPUTS))
+    return np.concatenate(xs), np.concatenate(ys)
+
+# Function to initialize weights (He initialization, input-major layout like the weight file)
+def init_layers(sizes, rng):
+    layers = []
+    for fan_in, fan_out in zip(sizes[:-1], sizes[1:]):
+        w = rng.standard_normal((fan_in, fan_out)) * np.sqrt(2.0 / fan_in)
+        b = np.zeros(fan_out)
+        layers.append([w, b])
+    return layers
+
+# Function to run the network forward, keeping activations for backpropagation
+def forward(layers, x):
+    activations = [x]
+    for i, (w, b) in enumerate(layers):
+        x = x @ w + b
+        if i + 1 < len(layers):
+            x = np.maximum(x, 0.0)
+        activations.append(x)
+    return activations
+
+# Function to compute mean squared error gradients for every layer
+def backward(layers, activations, target):
+    grads = []
+    delta = 2.0 * (activations[-1] - target) / target.size
+    for i in range(len(layers) - 1, -1, -1):
+        w, _ = layers[i]
+        grads.append((activations[i].T @ delta, delta.sum(axis=0)))
+        if i > 0:
+            delta = (delta @ w.T) * (activations[i] > 0.0)
+    return grads[::-1]
+
+# Function to train the MLP with minibatch Adam
+def train(x, y, hidden, epochs, batch_size, learning_rate, seed):
+    rng = np.random.default_rng(seed)
+    sizes = [INPUTS] + hidden + [OUTPUTS]
+    layers = init_layers(sizes, rng)
+    moments = [[np.zeros_like(p) for p in layer] for layer in layers]
+    velocities = [[np.zeros_like(p) for p in layer] for layer in layers]
+    beta1, beta2, eps = 0.9, 0.999, 1e-8
+    step = 0
+
+    for epoch in range(epochs):
+        order = rng.permutation(len(x))
+        for start in range(0, len(x), batch_size):
+            batch = order[start:start + batch_size]
+            grads = backward(layers, forward(layers, x[batch]), y[batch])
+            step += 1
+            for layer, grad, m, v in zip(layers, grads, moments, velocities):
+                for k in range(2):
+                    m[k] = beta1 * m[k] + (1 - beta1) * grad[k]
+                    v[k] = beta2 * v[k] + (1 - beta2) * grad[k] ** 2
+                    m_hat = m[k] / (1 - beta1 ** step)
+                    v_hat = v[k] / (1 - beta2 ** step)
+                    layer[k] -= learning_rate * m_hat / (np.sqrt(v_hat) + eps)
+        if (epoch + 1) % max(1, epochs // 10) == 0:
+            loss = np.mean((forward(layers, x)[-1] - y) ** 2)
+            print(f"Epoch {epoch + 1}/{epochs}: normalized MSE {loss:.5f}", file=sys.stderr)
+    return layers
+
+# Function to write the flat little-endian weight file read by policy_load() in policy.c
+def save_policy(path, layers, in_mean, in_scale, out_mean, out_scale):
+    sizes = [layers[0][0].shape[0]] + [w.shape[1] for w, _ in layers]
+    with open(path, "wb") as file:
+        file.write(POLICY_MAGIC)
+        file.write(struct.pack("<II", POLICY_VERSION, len(layers)))
+        file.write(struct.pack(f"<{len(sizes)}I", *sizes))
+        for array in (in_mean, in_scale, out_mean, out_scale):
+            file.write(np.asarray(array, dtype="<f4").tobytes())
+        for w, b in layers:
+            file.write(np.ascontiguousarray(w, dtype="<f4").tobytes())
+            file.write(np.asarray(b, dtype="<f4").tobytes())
+
+# Main function
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Train the neural torque policy for policy.c")
+    parser.add_argument("datasets", nargs="*", help="Files in the robot-control.txt format")
+    parser.add_argument("--generate", type=int, default=0, help="Number of simulated trajectories to add")
+    parser.add_argument("--simulation", default="./simulation", help="Path to the simulation binary")
+    parser.add_argument("--hidden", default="32,32", help="Comma-separated hidden layer widths")
+    parser.add_argument("--epochs", type=int, default=300)
+    parser.add_argument("--batch-size", type=int, default=64)
+    parser.add_argument("--learning-rate", type=float, default=3e-3)
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("-o", "--output", default="policy.bin")
+    args = parser.parse_args()
+
+    # The widths policy.c accepts, checked before any data is loaded
+    hidden = [int(width) for width in args.hidden.split(",") if width]
+    if len(hidden) + 1 > MAX_LAYERS or any(width < 1 or width > MAX_WIDTH for width in hidden):
+        print(f"Error: --hidden {args.hidden}: policy.c takes at most {MAX_LAYERS - 1} hidden layers "
+              f"of 1 to {MAX_WIDTH} units", file=sys.stderr)
+        sys.exit(1)
+
+    datasets = args.datasets
+    if not datasets and args.generate == 0 and os.path.exists("robot-control.txt"):
+        datasets = ["robot-control.txt"]
+
+    x, y = load_training_data(datasets, args.generate, args.simulation)
+    if len(x) == 0:
+        print("Error: no training rows found.", file=sys.stderr)
+        sys.exit(1)
+    print(f"Training on {len(x)} rows", file=sys.stderr)
+
+    # Normalize inputs and targets; the C engine applies the same affine maps
+    in_mean = x.mean(axis=0)
+    in_scale = 1.0 / np.maximum(x.std(axis=0), 1e-6)
+    out_mean = y.mean(axis=0)
+    out_scale = np.maximum(y.std(axis=0), 1e-6)
+
+    layers = train((x - in_mean) * in_scale, (y - out_mean) / out_scale,
+                   hidden, args.epochs, args.batch_size, args.learning_rate, args.seed)
+
+    rmse = np.sqrt(np.mean((forward(layers, (x - in_mean) * in_scale)[-1] * out_scale + out_mean - y) ** 2))
+    print(f"Training RMSE: {rmse:.3f} Nm", file=sys.stderr)
+
+    save_policy(args.output, layers, in_mean, in_scale, out_mean, out_scale)
+    print(f"Wrote {args.output}", file=sys.stderr)
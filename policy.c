@@ -0,0 +1,393 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+// This document is Licensed under Creative Commons CC0.
+// To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+// to this document to the public domain worldwide.
+// This document is distributed without any warranty.
+// You should have received a copy of the CC0 Public Domain Dedication along with this document.
+// If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+/*
+gcc -O3 -march=native policy.c -o policy -lm; ./simulation | ./policy policy.bin
+gcc -O3 -march=native -shared -fPIC -DPOLICY_LIBRARY policy.c -o libpolicy.so
+*/
+
+// Neural torque policy inference engine.
+// Evaluates the MLP written by policy-train.py: six thetas in (same column order as robot-control.txt),
+// two torques out. No dependencies besides libc; AVX2/FMA kernels are used when compiled for them.
+
+#define POLICY_MAGIC "EXOP"
+#define POLICY_VERSION 1
+#define POLICY_INPUTS 6          // Prev_Theta1..End_Theta2
+#define POLICY_OUTPUTS 2         // Torque1, Torque2
+#define POLICY_MAX_LAYERS 4
+#define POLICY_MAX_WIDTH 256
+#define POLICY_LANES 8           // Output widths are padded to a multiple of this
+#define POLICY_TILE 8            // Queries per pass of policy_infer_batch() (AVX2/FMA); each weight load serves all of them
+
+// Weight file layout (little-endian, see policy-train.py):
+//   char magic[4], uint32 version, uint32 layer_count, uint32 sizes[layer_count + 1]
+//   float in_mean[6], in_scale[6], out_mean[2], out_scale[2]
+//   per layer: float weights[in][out] (input-major), float bias[out]
+typedef struct {
+    int layer_count;
+    int sizes[POLICY_MAX_LAYERS + 1];   // Logical layer widths
+    int padded[POLICY_MAX_LAYERS + 1];  // Widths rounded up to POLICY_LANES
+    float in_mean[POLICY_INPUTS];
+    float in_scale[POLICY_INPUTS];
+    float out_mean[POLICY_OUTPUTS];
+    float out_scale[POLICY_OUTPUTS];
+    float *weights[POLICY_MAX_LAYERS];   // [in][padded out], zero padded
+    float *bias[POLICY_MAX_LAYERS];      // [padded out]
+    int8_t *qweights[POLICY_MAX_LAYERS]; // int8 copy of weights, same layout
+    float *qscale[POLICY_MAX_LAYERS];    // Per-output dequantization scale
+    int quantized;
+} Policy;
+
+// Function to allocate zeroed memory aligned for vector loads
+static void *policy_alloc(size_t bytes) {
+    size_t rounded = (bytes + 63) & ~(size_t)63;
+    void *p = aligned_alloc(64, rounded);
+    if (p != NULL) memset(p, 0, rounded);
+    return p;
+}
+
+// Function to release a policy returned by policy_load()
+void policy_free(Policy *p) {
+    if (p == NULL) return;
+    for (int l = 0; l < p->layer_count; l++) {
+        free(p->weights[l]);
+        free(p->bias[l]);
+        free(p->qweights[l]);
+        free(p->qscale[l]);
+    }
+    free(p);
+}
+
+// Function to quantize weights to int8 with one symmetric scale per output neuron
+static int policy_quantize(Policy *p) {
+    for (int l = 0; l < p->layer_count; l++) {
+        int in = p->sizes[l], out = p->padded[l + 1];
+        p->qweights[l] = policy_alloc((size_t)in * out);
+        p->qscale[l] = policy_alloc(sizeof(float) * out);
+        if (p->qweights[l] == NULL || p->qscale[l] == NULL) return 0;
+
+        for (int j = 0; j < out; j++) {
+            float max_abs = 0.0f;
+            for (int i = 0; i < in; i++) {
+                float a = fabsf(p->weights[l][i * out + j]);
+                if (a > max_abs) max_abs = a;
+            }
+            float scale = max_abs > 0.0f ? max_abs / 127.0f : 1.0f;
+            p->qscale[l][j] = scale;
+            for (int i = 0; i < in; i++) {
+                p->qweights[l][i * out + j] = (int8_t)lrintf(p->weights[l][i * out + j] / scale);
+            }
+        }
+    }
+    p->quantized = 1;
+    return 1;
+}
+
+// Function to load a policy weight file, optionally quantizing it to int8
+Policy *policy_load(const char *path, int quantize) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "Error: cannot open policy file %s\n", path);
+        return NULL;
+    }
+
+    Policy *p = calloc(1, sizeof(Policy));
+    if (p == NULL) goto no_memory;
+    char magic[4];
+    uint32_t version = 0, layer_count = 0;
+    if (fread(magic, 1, 4, f) != 4 || memcmp(magic, POLICY_MAGIC, 4) != 0 ||
+        fread(&version, 4, 1, f) != 1 || version != POLICY_VERSION ||
+        fread(&layer_count, 4, 1, f) != 1 || layer_count < 1 || layer_count > POLICY_MAX_LAYERS) {
+        fprintf(stderr, "Error: %s is not a version %d policy file\n", path, POLICY_VERSION);
+        goto fail;
+    }
+    p->layer_count = (int)layer_count;
+
+    for (int l = 0; l <= p->layer_count; l++) {
+        uint32_t size;
+        if (fread(&size, 4, 1, f) != 1) goto corrupt;
+        if (size < 1 || size > POLICY_MAX_WIDTH) {
+            fprintf(stderr, "Error: layer %d of policy %s has width %u; widths must be 1 to %d\n",
+                    l, path, size, POLICY_MAX_WIDTH);
+            goto fail;
+        }
+        p->sizes[l] = (int)size;
+        p->padded[l] = ((int)size + POLICY_LANES - 1) / POLICY_LANES * POLICY_LANES;
+    }
+    if (p->sizes[0] != POLICY_INPUTS || p->sizes[p->layer_count] != POLICY_OUTPUTS) goto corrupt;
+
+    if (fread(p->in_mean, sizeof(float), POLICY_INPUTS, f) != POLICY_INPUTS ||
+        fread(p->in_scale, sizeof(float), POLICY_INPUTS, f) != POLICY_INPUTS ||
+        fread(p->out_mean, sizeof(float), POLICY_OUTPUTS, f) != POLICY_OUTPUTS ||
+        fread(p->out_scale, sizeof(float), POLICY_OUTPUTS, f) != POLICY_OUTPUTS) goto corrupt;
+
+    for (int l = 0; l < p->layer_count; l++) {
+        int in = p->sizes[l], out = p->sizes[l + 1], out_padded = p->padded[l + 1];
+        p->weights[l] = policy_alloc(sizeof(float) * in * out_padded);
+        p->bias[l] = policy_alloc(sizeof(float) * out_padded);
+        if (p->weights[l] == NULL || p->bias[l] == NULL) goto no_memory;
+        for (int i = 0; i < in; i++) {
+            if (fread(p->weights[l] + i * out_padded, sizeof(float), out, f) != (size_t)out) goto corrupt;
+        }
+        if (fread(p->bias[l], sizeof(float), out, f) != (size_t)out) goto corrupt;
+    }
+    fclose(f);
+
+    if (quantize && !policy_quantize(p)) {
+        fprintf(stderr, "Error: out of memory quantizing policy %s\n", path);
+        policy_free(p);
+        return NULL;
+    }
+    return p;
+
+no_memory:
+    fprintf(stderr, "Error: out of memory loading policy %s\n", path);
+    goto fail;
+corrupt:
+    fprintf(stderr, "Error: policy file %s is truncated or malformed\n", path);
+fail:
+    fclose(f);
+    policy_free(p);
+    return NULL;
+}
+
+// Function to evaluate one dense layer: y = x W + b, with optional ReLU
+static void layer_forward(const Policy *p, int l, const float *x, float *y, int relu) {
+    int in = p->sizes[l], out = p->padded[l + 1];
+    const float *b = p->bias[l];
+#if defined(__AVX2__) && defined(__FMA__)
+    if (p->quantized) {
+        const int8_t *q = p->qweights[l];
+        for (int j = 0; j < out; j += 8) {
+            __m256 acc = _mm256_setzero_ps();
+            for (int i = 0; i < in; i++) {
+                __m128i q8 = _mm_loadl_epi64((const __m128i *)(q + i * out + j));
+                __m256 w = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(q8));
+                acc = _mm256_fmadd_ps(_mm256_set1_ps(x[i]), w, acc);
+            }
+            acc = _mm256_fmadd_ps(acc, _mm256_load_ps(p->qscale[l] + j), _mm256_load_ps(b + j));
+            if (relu) acc = _mm256_max_ps(acc, _mm256_setzero_ps());
+            _mm256_store_ps(y + j, acc);
+        }
+    } else {
+        const float *w = p->weights[l];
+        for (int j = 0; j < out; j += 8) {
+            __m256 acc = _mm256_load_ps(b + j);
+            for (int i = 0; i < in; i++) {
+                acc = _mm256_fmadd_ps(_mm256_set1_ps(x[i]), _mm256_load_ps(w + i * out + j), acc);
+            }
+            if (relu) acc = _mm256_max_ps(acc, _mm256_setzero_ps());
+            _mm256_store_ps(y + j, acc);
+        }
+    }
+#else
+    // Portable path, written so the compiler can vectorize the inner loop over outputs
+    float acc[POLICY_MAX_WIDTH];
+    for (int j = 0; j < out; j++) acc[j] = 0.0f;
+    if (p->quantized) {
+        const int8_t *q = p->qweights[l];
+        for (int i = 0; i < in; i++) {
+            for (int j = 0; j < out; j++) acc[j] += x[i] * (float)q[i * out + j];
+        }
+        for (int j = 0; j < out; j++) acc[j] = acc[j] * p->qscale[l][j] + b[j];
+    } else {
+        const float *w = p->weights[l];
+        for (int i = 0; i < in; i++) {
+            for (int j = 0; j < out; j++) acc[j] += x[i] * w[i * out + j];
+        }
+        for (int j = 0; j < out; j++) acc[j] += b[j];
+    }
+    for (int j = 0; j < out; j++) y[j] = relu && acc[j] < 0.0f ? 0.0f : acc[j];
+#endif
+}
+
+#if defined(__AVX2__) && defined(__FMA__)
+// Function to evaluate one dense layer for a tile of queries: Y = X W + b, with optional ReLU.
+// x and y hold POLICY_TILE rows of POLICY_MAX_WIDTH; every weight vector is loaded once for the whole tile.
+static void layer_forward_tile(const Policy *p, int l, const float *x, float *y, int relu) {
+    int in = p->sizes[l], out = p->padded[l + 1];
+    const float *b = p->bias[l];
+    for (int j = 0; j < out; j += 8) {
+        __m256 acc[POLICY_TILE];
+        for (int r = 0; r < POLICY_TILE; r++) acc[r] = _mm256_setzero_ps();
+        for (int i = 0; i < in; i++) {
+            __m256 w;
+            if (p->quantized) {
+                __m128i q8 = _mm_loadl_epi64((const __m128i *)(p->qweights[l] + i * out + j));
+                w = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(q8));
+            } else {
+                w = _mm256_load_ps(p->weights[l] + i * out + j);
+            }
+            for (int r = 0; r < POLICY_TILE; r++) {
+                acc[r] = _mm256_fmadd_ps(_mm256_set1_ps(x[r * POLICY_MAX_WIDTH + i]), w, acc[r]);
+            }
+        }
+        __m256 scale = p->quantized ? _mm256_load_ps(p->qscale[l] + j) : _mm256_set1_ps(1.0f);
+        for (int r = 0; r < POLICY_TILE; r++) {
+            __m256 v = _mm256_fmadd_ps(acc[r], scale, _mm256_load_ps(b + j));
+            if (relu) v = _mm256_max_ps(v, _mm256_setzero_ps());
+            _mm256_store_ps(y + r * POLICY_MAX_WIDTH + j, v);
+        }
+    }
+}
+#endif
+
+// Function to compute torques for a single query (matrix-vector products, lowest latency for one query)
+void policy_infer(const Policy *p, const float thetas[POLICY_INPUTS], float torques[POLICY_OUTPUTS]) {
+    _Alignas(64) float buf_a[POLICY_MAX_WIDTH];
+    _Alignas(64) float buf_b[POLICY_MAX_WIDTH];
+    for (int i = 0; i < POLICY_INPUTS; i++) {
+        buf_a[i] = (thetas[i] - p->in_mean[i]) * p->in_scale[i];
+    }
+
+    float *src = buf_a, *dst = buf_b;
+    for (int l = 0; l < p->layer_count; l++) {
+        layer_forward(p, l, src, dst, l + 1 < p->layer_count);
+        float *t = src; src = dst; dst = t;
+    }
+
+    for (int j = 0; j < POLICY_OUTPUTS; j++) {
+        torques[j] = src[j] * p->out_scale[j] + p->out_mean[j];
+    }
+}
+
+// Function to compute torques for n queries: thetas is n x 6, torques is n x 2 (both row-major).
+// The AVX2/FMA build runs POLICY_TILE queries at a time through matrix-matrix products, zero padding a short last
+// tile; the portable build has no registers to block a tile in and evaluates the queries one by one.
+void policy_infer_batch(const Policy *p, const float *thetas, float *torques, int n) {
+#if defined(__AVX2__) && defined(__FMA__)
+    _Alignas(64) float buf_a[POLICY_TILE * POLICY_MAX_WIDTH];
+    _Alignas(64) float buf_b[POLICY_TILE * POLICY_MAX_WIDTH];
+
+    for (int k = 0; k < n; k += POLICY_TILE) {
+        int rows = n - k < POLICY_TILE ? n - k : POLICY_TILE;
+        for (int r = 0; r < POLICY_TILE; r++) {
+            const float *x = thetas + (k + r) * POLICY_INPUTS;
+            for (int i = 0; i < POLICY_INPUTS; i++) {
+                buf_a[r * POLICY_MAX_WIDTH + i] = r < rows ? (x[i] - p->in_mean[i]) * p->in_scale[i] : 0.0f;
+            }
+        }
+
+        float *src = buf_a, *dst = buf_b;
+        for (int l = 0; l < p->layer_count; l++) {
+            layer_forward_tile(p, l, src, dst, l + 1 < p->layer_count);
+            float *t = src; src = dst; dst = t;
+        }
+
+        for (int r = 0; r < rows; r++) {
+            for (int j = 0; j < POLICY_OUTPUTS; j++) {
+                torques[(k + r) * POLICY_OUTPUTS + j] = src[r * POLICY_MAX_WIDTH + j] * p->out_scale[j] + p->out_mean[j];
+            }
+        }
+    }
+#else
+    for (int k = 0; k < n; k++) {
+        policy_infer(p, thetas + k * POLICY_INPUTS, torques + k * POLICY_OUTPUTS);
+    }
+#endif
+}
+
+
+#ifndef POLICY_LIBRARY
+
+// Function to read the current time in nanoseconds
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Function to measure single-query and batched latency on random inputs around the dataset range
+static void benchmark(const Policy *p) {
+    enum { BATCH = 1024, ROUNDS = 200 };
+    static float thetas[BATCH * POLICY_INPUTS];
+    static float torques[BATCH * POLICY_OUTPUTS];
+    for (int i = 0; i < BATCH * POLICY_INPUTS; i++) {
+        thetas[i] = (rand() % 2001 - 1000) / 1000.0f * 0.6f;
+    }
+
+    double start = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int k = 0; k < BATCH; k++) {
+            policy_infer(p, thetas + k * POLICY_INPUTS, torques + k * POLICY_OUTPUTS);
+        }
+    }
+    double single = (now_ns() - start) / ((double)ROUNDS * BATCH);
+
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        policy_infer_batch(p, thetas, torques, BATCH);
+    }
+    double batched = (now_ns() - start) / ((double)ROUNDS * BATCH);
+
+    printf("Layers: %d, quantized: %s\n", p->layer_count, p->quantized ? "int8" : "no");
+    printf("Single query: %.1f ns/query\n", single);
+    printf("Batch of %d: %.1f ns/query\n", BATCH, batched);
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    int quantize = 0, bench = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--int8") == 0) quantize = 1;
+        else if (strcmp(argv[i], "--bench") == 0) bench = 1;
+        else path = argv[i];
+    }
+    if (path == NULL) {
+        fprintf(stderr, "Usage: %s policy.bin [--int8] [--bench] < robot-control.txt\n", argv[0]);
+        return 1;
+    }
+
+    Policy *p = policy_load(path, quantize);
+    if (p == NULL) return 1;
+
+    if (bench) {
+        benchmark(p);
+        policy_free(p);
+        return 0;
+    }
+
+    // Read rows in the simulation output format and print the predicted torques.
+    // Rows that also carry reference torques are used to report the prediction error.
+    char line[512];
+    double err_sum = 0.0;
+    int err_count = 0;
+    printf("Torque1\tTorque2\n");
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        float x[POLICY_INPUTS], ref[POLICY_OUTPUTS], y[POLICY_OUTPUTS];
+        int n = sscanf(line, "%f\t%f\t%f\t%f\t%f\t%f\t%f\t%f",
+                       &x[0], &x[1], &x[2], &x[3], &x[4], &x[5], &ref[0], &ref[1]);
+        if (n < POLICY_INPUTS) continue; // Header or blank line
+
+        policy_infer(p, x, y);
+        printf("%.2f\t%.2f\n", y[0], y[1]);
+
+        if (n == POLICY_INPUTS + POLICY_OUTPUTS) {
+            err_sum += (y[0] - ref[0]) * (y[0] - ref[0]) + (y[1] - ref[1]) * (y[1] - ref[1]);
+            err_count += POLICY_OUTPUTS;
+        }
+    }
+    if (err_count > 0) {
+        fprintf(stderr, "RMSE against reference torques: %.3f Nm\n", sqrt(err_sum / err_count));
+    }
+
+    policy_free(p);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,166 @@
+import os
+import sys
+import json
+import time
+import http.client
+from urllib.parse import urlsplit
+import numpy as np
+from torque_index import read_rows, KEY_COLUMNS
+from torque_prompt import open_index, build_question, parse_torques, CANDIDATES
+
+# This document is Licensed under Creative Commons CC0.
+# To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+# to this document to the public domain worldwide.
+# This document is distributed without any warranty.
+# You should have received a copy of the CC0 Public Domain Dedication along with this document.
+# If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+# End-to-end latency benchmark of the LLM control path.
+#
+# Each step does what one control tick of robot-control-cerebras.py does: build the question for a
+# row of thetas from the torque index, send it to a chat completions endpoint, collect the streamed
+# chunks and parse the torques with parse_torques(). The rows come from a file in the robot-control.txt
+# format and are used in turn. Against mock-inference.py with no TTFT and no token rate limit the
+# result is the floor latency of the path itself; against a live service it is the real control
+# latency. Reports latency percentiles with a per-stage breakdown, tokens per step, the parse failure
+# rate and how often the parsed torques differ from those of the nearest row.
+#
+# Usage: python robot-control-bench.py [--base-url http://127.0.0.1:8000/v1] [--steps 1000]
+#                                      [--queries robot-test.txt] [--candidates 8] [--no-stream]
+#                                      [--model NAME] [--key-file PATH] [--warmup 10]
+
+SYSTEM_PROMPT = "Give me just the two torques, nothing else. Do not include thinking between tags in the answer."
+
+# Function to read an option value from the command line
+def option(name, default):
+    return type(default)(sys.argv[sys.argv.index(name) + 1]) if name in sys.argv else default
+
+class ChatEndpoint:
+    def __init__(self, base_url, api_key, model):
+        url = urlsplit(base_url.rstrip("/") + "/chat/completions")
+        connection = http.client.HTTPSConnection if url.scheme == "https" else http.client.HTTPConnection
+        self.connection = connection(url.netloc, timeout=60)
+        self.path = url.path
+        self.headers = {"Content-Type": "application/json", "Authorization": f"Bearer {api_key}"}
+        self.model = model
+
+    # Function to ask one question; returns (answer text, TTFT in s, chunks, completion tokens, prompt tokens)
+    def ask(self, question, stream=True):
+        body = json.dumps({
+            "model": self.model,
+            "messages": [
+                {"role": "system", "content": SYSTEM_PROMPT},
+                {"role": "user", "content": question}
+            ],
+            "stream": stream,
+            "temperature": 0,
+            "max_completion_tokens": 64
+        })
+        sent = time.perf_counter()
+        self.connection.request("POST", self.path, body, self.headers)
+        response = self.connection.getresponse()
+        if response.status != 200:
+            raise RuntimeError(f"HTTP {response.status}: {response.read().decode(errors='replace')}")
+
+        if not stream:
+            reply = json.loads(response.read())
+            usage = reply.get("usage", {})
+            return (reply["choices"][0]["message"]["content"], time.perf_counter() - sent, 1,
+                    usage.get("completion_tokens"), usage.get("prompt_tokens"))
+
+        # Server-sent events, handled like the streaming loop of the controllers
+        text, ttft, chunks, usage = "", None, 0, {}
+        while True:
+            line = response.readline()
+            if not line:
+                break
+            line = line.strip()
+            if not line.startswith(b"data: "):
+                continue
+            data = line[6:]
+            if data == b"[DONE]":
+                break
+            event = json.loads(data)
+            usage = event.get("usage") or usage
+            if event.get("choices"):
+                content = event["choices"][0].get("delta", {}).get("content")
+                if content:
+                    if ttft is None:
+                        ttft = time.perf_counter() - sent
+                    text += content
+                    chunks += 1
+        response.read()  # Drain the terminating chunk so the connection can be reused
+        return (text, ttft if ttft is not None else time.perf_counter() - sent, chunks,
+                usage.get("completion_tokens", chunks), usage.get("prompt_tokens"))
+
+# Function to format percentiles of a list of seconds as milliseconds
+def percentiles(values):
+    values = np.asarray(values) * 1000.0
+    return "  ".join(f"{name} {np.percentile(values, q):8.3f}" for name, q in
+                     (("p50", 50), ("p90", 90), ("p99", 99))) + f"  max {values.max():8.3f}"
+
+# Main function
+if __name__ == "__main__":
+    base_url = option("--base-url", "http://127.0.0.1:8000/v1")
+    steps = option("--steps", 1000)
+    warmup = option("--warmup", 10)
+    candidates = option("--candidates", CANDIDATES)
+    stream = "--no-stream" not in sys.argv
+    api_key = "local"
+    if "--key-file" in sys.argv:
+        with open(os.path.expanduser(option("--key-file", "")), "r") as key_file:
+            api_key = key_file.read().strip()
+
+    queries = read_rows(option("--queries", "robot-test.txt"))
+    if not queries:
+        print("Error: no query rows")
+        exit(1)
+    index = open_index()
+    endpoint = ChatEndpoint(base_url, api_key, option("--model", "llama-4-scout-17b-16e-instruct"))
+
+    build, ttft, total, parse = [], [], [], []
+    completion_tokens, prompt_tokens, prompt_chars, chunk_counts = [], [], [], []
+    failures, mismatches = 0, 0
+    for step in range(warmup + steps):
+        thetas = queries[step % len(queries)][:KEY_COLUMNS]
+
+        start = time.perf_counter()
+        question = build_question(index, thetas, candidates)
+        built = time.perf_counter()
+        answer, first_token, chunks, tokens, question_tokens = endpoint.ask(question, stream)
+        answered = time.perf_counter()
+        torques = parse_torques(answer)
+        parsed = time.perf_counter()
+        if step < warmup:
+            continue
+
+        build.append(built - start)
+        ttft.append(first_token)
+        total.append(parsed - start)
+        parse.append(parsed - answered)
+        chunk_counts.append(chunks)
+        completion_tokens.append(tokens)
+        prompt_chars.append(len(question))
+        if question_tokens is not None:
+            prompt_tokens.append(question_tokens)
+
+        if torques is None:
+            failures += 1
+            continue
+        nearest = index.nearest(thetas)
+        if nearest is not None and (abs(torques[0] - nearest[KEY_COLUMNS]) > 0.006 or
+                                    abs(torques[1] - nearest[KEY_COLUMNS + 1]) > 0.006):
+            mismatches += 1
+
+    print(f"Endpoint {base_url}, {'streaming' if stream else 'single response'}, {steps} steps, "
+          f"{candidates} candidate rows, index of {len(index)} rows")
+    print(f"Step latency (ms)      {percentiles(total)}")
+    print(f"  Question build (ms)  {percentiles(build)}")
+    print(f"  First token (ms)     {percentiles(ttft)}")
+    print(f"  Parse (ms)           {percentiles(parse)}")
+    print(f"Prompt per step        {np.mean(prompt_chars):.0f} chars"
+          + (f", {np.mean(prompt_tokens):.0f} tokens" if prompt_tokens else ""))
+    print(f"Completion per step    {np.mean(completion_tokens):.1f} tokens in {np.mean(chunk_counts):.1f} chunks")
+    print(f"Parse failures         {failures} ({100.0 * failures / steps:.2f}%)")
+    print(f"Wrong torques          {mismatches} ({100.0 * mismatches / steps:.2f}%)")
+    print(f"Steps per second       {steps / sum(total):.1f}")
@@ -1,9 +1,10 @@
 import os
-import re
+import sys
 import math
 import random
 import time
 from cerebras.cloud.sdk import Cerebras
+from torque_prompt import open_index, build_question, parse_torques, CANDIDATES
 
 # This document is Licensed under Creative Commons CC0.
 # To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
@@ -30,66 +31,15 @@ theta2 = 0.0   # Angle of second rod (radians)
 omega1 = 0.0   # Angular velocity of first rod (rad/s)
 omega2 = 0.0   # Angular velocity of second rod (rad/s)
 
-# Function to compute gravitational torque for each joint
-def compute_gravitational_torques(theta1, theta2):
-    # Gravitational torque on first rod (negative when rod is at positive angle)
-    tau1 = -M1 * G * L1 * math.sin(theta1) - M2 * G * L1 * math.sin(theta1)
-    # Gravitational torque on second rod (negative when rod is at positive angle)
-    tau2 = -M2 * G * L2 * math.sin(theta2)
-    return tau1, tau2
-
-# Function to simulate one time step
-def simulate_step(theta1, omega1, theta2, omega2, tau1, tau2):
-    # Angular accelerations (τ = Iα, I = mL² for each rod)
-    alpha1 = tau1 / (M1 * L1 * L1)  # First joint
-    alpha2 = tau2 / (M2 * L2 * L2)  # Second joint
-
-    # Update angular velocities and angles
-    omega1 += alpha1 * DT
-    omega2 += alpha2 * DT
-    theta1 += omega1 * DT
-    theta2 += omega2 * DT
-    
-    return theta1, omega1, theta2, omega2
-
-# Improved parsing for the torque values
-def parse_torques(response_text):
-    # First try the standard regex pattern for numbers
-    numbers = re.findall(r'-?\d+\.?\d*', response_text)
-    
-    if len(numbers) >= 2:
-        return float(numbers[0]), float(numbers[1])
-    
-    # If standard pattern fails, try other formats
-    # Try comma-separated pattern (e.g. "-10.5, 15.3")
-    comma_pattern = re.search(r'(-?\d+\.?\d*)\s*,\s*(-?\d+\.?\d*)', response_text)
-    if comma_pattern:
-        return float(comma_pattern.group(1)), float(comma_pattern.group(2))
-    
-    # Try newline-separated pattern (e.g. "-10.5\n15.3")
-    newline_pattern = re.search(r'(-?\d+\.?\d*)\s*[\n\r]+\s*(-?\d+\.?\d*)', response_text)
-    if newline_pattern:
-        return float(newline_pattern.group(1)), float(newline_pattern.group(2))
-    
-    # Try tab-separated pattern (e.g. "-10.5\t15.3")
-    tab_pattern = re.search(r'(-?\d+\.?\d*)\s*\t\s*(-?\d+\.?\d*)', response_text)
-    if tab_pattern:
-        return float(tab_pattern.group(1)), float(tab_pattern.group(2))
-    
-    # If all patterns fail, return None
-    return None
+# Physics comes from the C core when it is built, otherwise from pure Python (see leg_physics.py)
+from leg_physics import compute_gravitational_torques, simulate_step
 
 # Main simulation function
-def simulate_arm(api_client, max_steps=1000):
+def simulate_arm(api_client, max_steps=1000, candidates=CANDIDATES):
     global theta1, theta2, omega1, omega2
     
-    # Load the dataset from robot-control.txt
-    try:
-        with open("robot-control.txt", "r", encoding="utf-8") as file:
-            dataset = file.read().strip()
-    except FileNotFoundError:
-        print("Warning: robot-control.txt not found. Using empty dataset.")
-        dataset = ""
+    # Open the torque index; each question carries only the rows nearest to the current thetas
+    index = open_index()
     
     target_theta1 = 0.0  # Target angle for first rod (0°)
     target_theta2 = 0.0  # Target angle for second rod (0°)
@@ -110,14 +60,10 @@ def simulate_arm(api_client, max_steps=1000):
         start_omega1 = omega1
         start_omega2 = omega2
         
-        # Create the question with the theta values
-        question_base = (f"I give a reference line and a data table. Find the closest line of theta numbers as key in the table for the reference number. "
-                        f"Give me the torques. Give me just the two numbers, nothing else.\n"
-                        f"Prev_Theta1\tPrev_Theta2\tStart_Theta1\tStart_Theta2\tEnd_Theta1\tEnd_Theta2\n"
-                        f"{prev_theta1:.6f}\t{prev_theta2:.6f}\t{start_theta1:.6f}\t{start_theta2:.6f}\t{theta1:.6f}\t{theta2:.6f}")
-        # print(f"Question: {question_base}")
-        # Append the dataset to the question
-        full_question = question_base + "\n\n" + dataset
+        # Create the question with the theta values and their nearest rows from the dataset
+        full_question = build_question(index, [prev_theta1, prev_theta2, start_theta1, start_theta2, theta1, theta2],
+                                       candidates)
+        # print(f"Question: {full_question}")
         
         # Make API call to get torques using streaming
         response = api_client.chat.completions.create(
@@ -203,12 +149,19 @@ if __name__ == "__main__":
     # Initialize random seed
     random.seed(int(time.time()))
     
-    # Get API key from file
-    cerebras_api_key = get_api_key()
+    # Optional endpoint override, e.g. a local mock: --base-url http://127.0.0.1:8000/v1 [--candidates K]
+    base_url = sys.argv[sys.argv.index("--base-url") + 1].rstrip("/") if "--base-url" in sys.argv else None
+    if base_url is not None and base_url.endswith("/v1"):
+        base_url = base_url[:-len("/v1")]  # Same form as for the other clients; the Cerebras SDK adds /v1 itself
+    candidates = int(sys.argv[sys.argv.index("--candidates") + 1]) if "--candidates" in sys.argv else CANDIDATES
+    
+    # Get API key from file; a local endpoint does not need one
+    cerebras_api_key = get_api_key() if base_url is None else "local"
     
     # Initialize Cerebras client
     client = Cerebras(
-        api_key=cerebras_api_key
+        api_key=cerebras_api_key,
+        base_url=base_url
     )
     
     # Set initial conditions - 30° for both rods (π/6 radians)
@@ -216,4 +169,4 @@ if __name__ == "__main__":
     theta2 = math.pi / 6
     
     # Run simulation
-    simulate_arm(client)
+    simulate_arm(client, candidates=candidates)
@@ -1,9 +1,12 @@
 import os
 import re
+import sys
 import math
+import ctypes
 import random
 import time
 import numpy as np
+from torque_index import TorqueIndex, COLUMNS, read_rows
 
 # This document is Licensed under Creative Commons CC0.
 # To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
@@ -30,97 +33,69 @@ theta2 = 0.0   # Angle of second rod (radians)
 omega1 = 0.0   # Angular velocity of first rod (rad/s)
 omega2 = 0.0   # Angular velocity of second rod (rad/s)
 
-# Function to compute gravitational torque for each joint
-def compute_gravitational_torques(theta1, theta2):
-    # Gravitational torque on first rod (negative when rod is at positive angle)
-    tau1 = -M1 * G * L1 * math.sin(theta1) - M2 * G * L1 * math.sin(theta1)
-    # Gravitational torque on second rod (negative when rod is at positive angle)
-    tau2 = -M2 * G * L2 * math.sin(theta2)
-    return tau1, tau2
+# Physics comes from the C core when it is built, otherwise from pure Python (see leg_physics.py)
+from leg_physics import compute_gravitational_torques, simulate_step
 
-# Function to simulate one time step
-def simulate_step(theta1, omega1, theta2, omega2, tau1, tau2):
-    # Angular accelerations (τ = Iα, I = mL² for each rod)
-    alpha1 = tau1 / (M1 * L1 * L1)  # First joint
-    alpha2 = tau2 / (M2 * L2 * L2)  # Second joint
-
-    # Update angular velocities and angles
-    omega1 += alpha1 * DT
-    omega2 += alpha2 * DT
-    theta1 += omega1 * DT
-    theta2 += omega2 * DT
-    
-    return theta1, omega1, theta2, omega2
-
-# Function to load dataset from robot-control.txt
-def load_dataset():
+# Function to open the torque index, seeding it from robot-control.txt on first use
+def load_dataset(index_dir="robot-control.idx"):
     try:
-        with open("robot-control.txt", "r", encoding="utf-8") as file:
-            lines = file.readlines()
-        
-        # Skip the header line
-        data_lines = lines[1:] if len(lines) > 1 else []
-        
-        # Parse each line into a data entry
-        dataset = []
-        for line in data_lines:
-            values = line.strip().split('\t')
-            if len(values) >= 8:  # Ensure we have all columns
-                entry = {
-                    'prev_theta1': float(values[0]),
-                    'prev_theta2': float(values[1]),
-                    'start_theta1': float(values[2]),
-                    'start_theta2': float(values[3]),
-                    'end_theta1': float(values[4]),
-                    'end_theta2': float(values[5]),
-                    'tau1': float(values[6]),
-                    'tau2': float(values[7])
-                }
-                dataset.append(entry)
-        
-        return dataset
+        index = TorqueIndex(index_dir)
+        if len(index) == 0:
+            index.insert(read_rows("robot-control.txt"))
+            index.flush()
+        return index
     
     except Exception as e:
         print(f"Error loading dataset: {str(e)}")
-        return []
+        return None
 
 # Function to find the best matching thetas in the dataset
 def find_best_match(dataset, prev_theta1, prev_theta2, start_theta1, start_theta2, end_theta1, end_theta2):
     if not dataset:
         return None
     
-    # Create array of query thetas
-    query = np.array([prev_theta1, prev_theta2, start_theta1, start_theta2, end_theta1, end_theta2])
+    # Exact Euclidean nearest row over the six thetas, see torque_index.py
+    row = dataset.nearest([prev_theta1, prev_theta2, start_theta1, start_theta2, end_theta1, end_theta2])
+    if row is None:
+        return None
     
-    best_match = None
-    min_distance = float('inf')
+    return dict(zip(COLUMNS, (float(v) for v in row)))
+
+# Function to load the neural policy through libpolicy.so (see policy.c and policy-train.py)
+def load_policy(path, quantize=False, library="./libpolicy.so"):
+    try:
+        lib = ctypes.CDLL(os.path.abspath(library))
+    except OSError as e:
+        print(f"Error loading {library}: {str(e)}")
+        return None
     
-    # Find the closest match using Euclidean distance
-    for entry in dataset:
-        # Create array of entry thetas
-        entry_thetas = np.array([
-            entry['prev_theta1'], entry['prev_theta2'],
-            entry['start_theta1'], entry['start_theta2'],
-            entry['end_theta1'], entry['end_theta2']
-        ])
-        
-        # Calculate Euclidean distance
-        distance = np.sqrt(np.sum((query - entry_thetas)**2))
-        
-        # Update best match if this is closer
-        if distance < min_distance:
-            min_distance = distance
-            best_match = entry
+    lib.policy_load.restype = ctypes.c_void_p
+    lib.policy_load.argtypes = [ctypes.c_char_p, ctypes.c_int]
+    lib.policy_infer.restype = None
+    lib.policy_infer.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_float), ctypes.POINTER(ctypes.c_float)]
+    
+    handle = lib.policy_load(path.encode(), int(quantize))
+    if not handle:
+        return None
+    
+    thetas = (ctypes.c_float * 6)()
+    torques = (ctypes.c_float * 2)()
     
-    return best_match
+    # Return a matcher replacement: six thetas in, two torques out
+    def infer(*query):
+        thetas[:] = query
+        lib.policy_infer(handle, thetas, torques)
+        return torques[0], torques[1]
+    
+    return infer
 
 # Main simulation function
-def simulate_arm(max_steps=1000):
+def simulate_arm(max_steps=1000, policy=None, record=False):
     global theta1, theta2, omega1, omega2
     
     # Load the dataset
     dataset = load_dataset()
-    if not dataset:
+    if not dataset and policy is None:
         print("Error: Could not load dataset. Using gravitational torques only.")
     
     target_theta1 = 0.0  # Target angle for first rod (0°)
@@ -142,8 +117,10 @@ def simulate_arm(max_steps=1000):
         start_omega1 = omega1
         start_omega2 = omega2
         
-        # Use local search to find best matching torques
-        if dataset:
+        # Use the neural policy or local search to find best matching torques
+        if policy is not None:
+            tau1, tau2 = policy(prev_theta1, prev_theta2, start_theta1, start_theta2, theta1, theta2)
+        elif dataset:
             best_match = find_best_match(
                 dataset, 
                 prev_theta1, prev_theta2, 
@@ -184,6 +161,12 @@ def simulate_arm(max_steps=1000):
             abs(theta2-target_theta2) < 0.01 and abs(omega2) < 0.01):
             break
     
+    # On request, append this rollout to the index so the next run can match against it. Never the neural
+    # policy's rollouts: the index is the reference set of the matchers and the LLM prompts.
+    if record and policy is None and dataset is not None:
+        dataset.insert(simulation_data)
+        dataset.flush()
+    
     return simulation_data
 
 # Main function
@@ -195,5 +178,17 @@ if __name__ == "__main__":
     theta1 = math.pi / 6
     theta2 = math.pi / 6
     
+    # Optional neural policy: python robot-control-local.py --policy policy.bin [--int8]
+    policy = None
+    if "--policy" in sys.argv:
+        policy = load_policy(sys.argv[sys.argv.index("--policy") + 1], "--int8" in sys.argv)
+        if policy is None:
+            print("Error: Could not load policy. Falling back to dataset matching.")
+    
+    # Optional recording of the rollout into robot-control.idx: --record (ignored with --policy)
+    record = "--record" in sys.argv
+    if record and policy is not None:
+        print("Warning: --record is ignored with --policy; the index only holds matched rollouts.")
+    
     # Run simulation
-    simulate_arm()
\ No newline at end of file
+    simulate_arm(policy=policy, record=record)
\ No newline at end of file
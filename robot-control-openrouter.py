@@ -1,9 +1,10 @@
 import os
-import re
+import sys
 import math
 import random
 import time
 import requests
+from torque_prompt import open_index, build_question, parse_torques, CANDIDATES
 
 # This document is Licensed under Creative Commons CC0.
 # To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
@@ -39,8 +40,9 @@ def get_api_key():
         print(f"Error reading API key: {e}")
         exit(1)
 
-# Get API key from file
-OPENROUTER_API_KEY = get_api_key()
+# API key and endpoint; the main function reads the key from file unless --base-url points elsewhere
+OPENROUTER_API_KEY = None
+OPENROUTER_URL = "https://openrouter.ai/api/v1/chat/completions"
 
 # State variables
 theta1 = 0.0   # Angle of first rod (radians)
@@ -48,34 +50,15 @@ theta2 = 0.0   # Angle of second rod (radians)
 omega1 = 0.0   # Angular velocity of first rod (rad/s)
 omega2 = 0.0   # Angular velocity of second rod (rad/s)
 
-# Function to compute gravitational torque for each joint
-def compute_gravitational_torques(theta1, theta2):
-    # Gravitational torque on first rod (negative when rod is at positive angle)
-    tau1 = -M1 * G * L1 * math.sin(theta1) - M2 * G * L1 * math.sin(theta1)
-    # Gravitational torque on second rod (negative when rod is at positive angle)
-    tau2 = -M2 * G * L2 * math.sin(theta2)
-    return tau1, tau2
-
-# Function to simulate one time step
-def simulate_step(theta1, omega1, theta2, omega2, tau1, tau2):
-    # Angular accelerations (τ = Iα, I = mL² for each rod)
-    alpha1 = tau1 / (M1 * L1 * L1)  # First joint
-    alpha2 = tau2 / (M2 * L2 * L2)  # Second joint
-
-    # Update angular velocities and angles
-    omega1 += alpha1 * DT
-    omega2 += alpha2 * DT
-    theta1 += omega1 * DT
-    theta2 += omega2 * DT
-    
-    return theta1, omega1, theta2, omega2
+# Physics comes from the C core when it is built, otherwise from pure Python (see leg_physics.py)
+from leg_physics import compute_gravitational_torques, simulate_step
 
 # Function to get torques from OpenRouter API
 def get_torques_from_api(question_with_dataset):
     try:
         # Call OpenRouter API
         response = requests.post(
-            "https://openrouter.ai/api/v1/chat/completions",
+            OPENROUTER_URL,
             headers={
                 "Authorization": f"Bearer {OPENROUTER_API_KEY}",
                 "Content-Type": "application/json"
@@ -114,9 +97,12 @@ def get_torques_from_api(question_with_dataset):
         return None
 
 # Main simulation function
-def simulate_arm(max_steps=1000):
+def simulate_arm(max_steps=1000, candidates=CANDIDATES):
     global theta1, theta2, omega1, omega2
     
+    # Open the torque index; each question carries only the rows nearest to the current thetas
+    index = open_index()
+    
     target_theta1 = 0.0  # Target angle for first rod (0°)
     target_theta2 = 0.0  # Target angle for second rod (0°)
     
@@ -136,36 +122,21 @@ def simulate_arm(max_steps=1000):
         start_omega1 = omega1
         start_omega2 = omega2
         
-        # Format the question
-        question = (f"Find the best matching line for these theta numbers in the dataset below. "
-                   f"Give me the torques of tau1 and tau2. Give me just the two torque numbers, nothing else.\n"
-                   f"{prev_theta1:.6f}\t{prev_theta2:.6f}\t{start_theta1:.6f}\t{start_theta2:.6f}\t{theta1:.6f}\t{theta2:.6f}")
-        
-        # Read the dataset 
-        try:
-            with open("robot-control.txt", "r", encoding="utf-8") as file:
-                dataset = file.read().strip()
-                # Combine question with dataset
-                question_with_dataset = question + "\n\n" + dataset
-        except FileNotFoundError:
-            print("Warning: robot-control.txt not found. Using question without dataset.")
-            question_with_dataset = question
+        # Format the question with the theta values and their nearest rows from the dataset
+        question_with_dataset = build_question(
+            index, [prev_theta1, prev_theta2, start_theta1, start_theta2, theta1, theta2], candidates)
         
         # Get torques from OpenRouter API
         response_text = get_torques_from_api(question_with_dataset)
 
         # Parse the two float numbers using regular expressions
-        if response_text:
-            numbers = re.findall(r'-?\d+\.?\d*', response_text)
-            
-            # Extract torques if found
-            if len(numbers) >= 2:
-                tau1 = float(numbers[0])
-                tau2 = float(numbers[1])
-            else:
-                # Fallback to gravitational torques if API fails
-                tau1, tau2 = compute_gravitational_torques(theta1, theta2)
-                print(f"Warning: Could not parse torques from response: {response_text}")
+        torques = parse_torques(response_text) if response_text else None
+        if torques:
+            tau1, tau2 = torques
+        elif response_text:
+            # Fallback to gravitational torques if the answer has no torques
+            tau1, tau2 = compute_gravitational_torques(theta1, theta2)
+            print(f"Warning: Could not parse torques from response: {response_text}")
         else:
             # Fallback to gravitational torques if API fails
             tau1, tau2 = compute_gravitational_torques(theta1, theta2)
@@ -201,9 +172,18 @@ if __name__ == "__main__":
     # Initialize random seed
     random.seed(int(time.time()))
     
+    # Optional endpoint override, e.g. a local mock: --base-url http://127.0.0.1:8000/v1 [--candidates K]
+    if "--base-url" in sys.argv:
+        OPENROUTER_URL = sys.argv[sys.argv.index("--base-url") + 1].rstrip("/") + "/chat/completions"
+        OPENROUTER_API_KEY = "local"
+    else:
+        # Get API key from file
+        OPENROUTER_API_KEY = get_api_key()
+    candidates = int(sys.argv[sys.argv.index("--candidates") + 1]) if "--candidates" in sys.argv else CANDIDATES
+    
     # Set initial conditions - 30° for both rods (π/6 radians)
     theta1 = math.pi / 6
     theta2 = math.pi / 6
     
     # Run simulation
-    simulate_arm()
+    simulate_arm(candidates=candidates)
@@ -1,6 +1,7 @@
 import requests
 import json
 import os
+import sys
 from pathlib import Path
 
 # This document is Licensed under Creative Commons CC0.
@@ -40,10 +41,15 @@ except FileNotFoundError:
 command = "Find the best matching line for these theta numbers in the dataset below. Give me the torques. Give me just the two numbers, nothing else.\n0.551393\t0.531838\t0.553141\t0.532356\t0.553141\t0.532356\n\n"
 question = command + original_content
 
-# Get API key from file
-api_key = get_api_key()
+# Optional endpoint override, e.g. mock-inference.py: --base-url http://127.0.0.1:8000/v1
+if "--base-url" in sys.argv:
+  url = sys.argv[sys.argv.index("--base-url") + 1].rstrip("/") + "/chat/completions"
+  api_key = "local"
+else:
+  # Get API key from file
+  api_key = get_api_key()
+  url = "https://openrouter.ai/api/v1/chat/completions"
 
-url = "https://openrouter.ai/api/v1/chat/completions"
 headers = {
   "Authorization": f"Bearer {api_key}",
   "Content-Type": "application/json"
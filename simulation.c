@@ -1,7 +1,8 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h> // For rand() and srand()
-#include <time.h>   // For time()
+#include <time.h>   // For time() and clock_gettime()
+#include <string.h> // For memcpy()
 
 // This document is Licensed under Creative Commons CC0.
 // To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
@@ -12,64 +13,19 @@
 
 /*
 gcc simulation.c -o simulation -lSDL2 -lm $(sdl2-config --cflags --libs); ./simulation
+./simulation [--mpc] [--ground Y | --no-contact] [start_theta1 start_theta2 [seed]]
+./simulation --bench
 */
 
-// Constants
-#define G 9.81       // Gravity (m/s²)
-#define L1 1.0       // Length of first rod (m)
-#define L2 1.5       // Length of second rod (m)
-#define M1 1.0       // Mass of first rod (kg)
-#define M2 1.5       // Mass of second rod (kg)
-#define DT 0.01      // Time step (s)
-#define KP1 50.0     // Proportional gain for joint 1
-#define KD1 20.0     // Derivative gain for joint 1
-#define KP2 50.0     // Proportional gain for joint 2
-#define KD2 20.0     // Derivative gain for joint 2
+#include "physics.h"
+#include "mpc.h"
 
 // State variables
 double theta1 = 0.0;  // Angle of first rod (radians)
 double omega1 = 0.0;  // Angular velocity of first rod (rad/s)
 double theta2 = 0.0;  // Angle of second rod (radians)
 double omega2 = 0.0;  // Angular velocity of second rod (rad/s)
-
-// Function to compute gravitational torque for each joint
-void compute_gravitational_torques(double theta1, double theta2, double *tau1, double *tau2) {
-    // Gravitational torque on first rod (negative when rod is at positive angle)
-    *tau1 = -M1 * G * L1 * sin(theta1) - M2 * G * L1 * sin(theta1); // Second rod's mass affects first joint
-    // Gravitational torque on second rod (negative when rod is at positive angle)
-    *tau2 = -M2 * G * L2 * sin(theta2);
-}
-
-// Function to compute control torque using PD controller
-void compute_control_torques(double theta1, double omega1, double theta2, double omega2, double *tau1, double *tau2) {
-    // Error-correcting torques (negative feedback for stability)
-    double control_tau1 = -KP1 * theta1 - KD1 * omega1; 
-    double control_tau2 = -KP2 * theta2 - KD2 * omega2;
-    
-    // Add random noise of ±10% to simulate real-world conditions
-    double noise_factor1 = 1.0 + (rand() % 201 - 100) / 1000.0; // Range: 0.9 to 1.1
-    double noise_factor2 = 1.0 + (rand() % 201 - 100) / 1000.0; // Range: 0.9 to 1.1
-    
-    control_tau1 *= noise_factor1;
-    control_tau2 *= noise_factor2;
-    
-    // Add control torque to gravitational torque
-    *tau1 += control_tau1;
-    *tau2 += control_tau2;
-}
-
-// Function to simulate one time step
-void simulate_step(double *theta1, double *omega1, double *theta2, double *omega2, double tau1, double tau2) {
-    // Angular accelerations (τ = Iα, I = mL² for each rod)
-    double alpha1 = (tau1) / (M1 * L1 * L1); // First joint
-    double alpha2 = (tau2) / (M2 * L2 * L2); // Second joint
-
-    // Update angular velocities and angles
-    *omega1 += alpha1 * DT;
-    *omega2 += alpha2 * DT;
-    *theta1 += *omega1 * DT;
-    *theta2 += *omega2 * DT;
-}
+int use_mpc = 0;      // Control with mpc.h instead of PD (--mpc)
 
 // Main simulation loop
 void simulate_arm() {
@@ -81,7 +37,8 @@ void simulate_arm() {
     double prev_theta1 = theta1;
     double prev_theta2 = theta2;
 
-    // Updated header without time
+    // Updated header without time. Torque1/Torque2 are the gravity and controller torques passed to simulate_step();
+    // the ground reaction is not included, since simulate_step() adds it from the state.
     printf("Prev_Theta1\tPrev_Theta2\tStart_Theta1\tStart_Theta2\tEnd_Theta1\tEnd_Theta2\tTorque1\tTorque2\n");
     
     for (int i = 0; i < max_steps; i++) {
@@ -94,7 +51,11 @@ void simulate_arm() {
         // Calculate torques
         double tau1 = 0.0, tau2 = 0.0;
         compute_gravitational_torques(theta1, theta2, &tau1, &tau2);
-        compute_control_torques(theta1, omega1, theta2, omega2, &tau1, &tau2);
+        if (use_mpc) {
+            compute_mpc_torques(theta1, omega1, theta2, omega2, &tau1, &tau2);
+        } else {
+            compute_control_torques(theta1, omega1, theta2, omega2, &tau1, &tau2);
+        }
 
         // Update state
         simulate_step(&theta1, &omega1, &theta2, &omega2, tau1, tau2);
@@ -114,15 +75,62 @@ void simulate_arm() {
         if (fabs(theta1-target_theta1) < 0.01 && fabs(omega1) < 0.01 && 
             fabs(theta2-target_theta2) < 0.01 && fabs(omega2) < 0.01) break;
     }
+
+    if (use_mpc) mpc_print_summary();
 }
 
-int main() {
-    // Initialize random seed using current time
-    srand((unsigned int)time(NULL));
+// Function to time batched steps (gravity, noise-free PD and integration) with and without ground contact.
+// Each figure is the best of several runs, so a descheduled run does not skew the ratio.
+void benchmark_step() {
+    enum { LEGS = 1024, STEPS = 2000, RUNS = 5 };
+    static double th1[LEGS], om1[LEGS], th2[LEGS], om2[LEGS], t1[LEGS], t2[LEGS];
+    double ns[2] = { INFINITY, INFINITY };
+
+    for (int run = 0; run < RUNS; run++) {
+        for (int pass = 0; pass < 2; pass++) {
+            use_contact = pass;
+            for (int i = 0; i < LEGS; i++) {
+                // Spread of start angles, some of which fold the foot onto the ground
+                th1[i] = -1.5 + 3.0 * i / LEGS;
+                th2[i] = 1.5 - 3.0 * i / LEGS;
+                om1[i] = om2[i] = 0.0;
+            }
+            double start = now_us();
+            for (int s = 0; s < STEPS; s++) {
+                compute_external_torques_batch(LEGS, th1, om1, th2, om2, t1, t2);
+                for (int i = 0; i < LEGS; i++) {
+                    t1[i] += -KP1 * th1[i] - KD1 * om1[i];
+                    t2[i] += -KP2 * th2[i] - KD2 * om2[i];
+                }
+                integrate_step_batch(LEGS, th1, om1, th2, om2, t1, t2);
+            }
+            ns[pass] = fmin(ns[pass], (now_us() - start) * 1e3 / ((double)LEGS * STEPS));
+        }
+    }
+    printf("Step without contact: %.1f ns/leg\n", ns[0]);
+    printf("Step with contact: %.1f ns/leg (%.2fx)\n", ns[1], ns[1] / ns[0]);
+}
+
+int main(int argc, char **argv) {
+    // Separate the controller option from the positional arguments
+    char *args[3];
+    int count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mpc") == 0) use_mpc = 1;
+        else if (strcmp(argv[i], "--no-contact") == 0) use_contact = 0;
+        else if (strcmp(argv[i], "--ground") == 0 && i + 1 < argc) ground_y = atof(argv[++i]);
+        else if (strcmp(argv[i], "--bench") == 0) {
+            benchmark_step();
+            return 0;
+        } else if (count < 3) args[count++] = argv[i];
+    }
+
+    // Initialize random seed using current time, or the seed given as third argument
+    srand(count > 2 ? (unsigned int)strtoul(args[2], NULL, 10) : (unsigned int)time(NULL));
     
-    // Example: Start at 30° for both rods (π/6 radians)
-    theta1 = M_PI / 6;
-    theta2 = M_PI / 6;
+    // Example: Start at 30° for both rods (π/6 radians), unless start angles are given
+    theta1 = count > 1 ? atof(args[0]) : M_PI / 6;
+    theta2 = count > 1 ? atof(args[1]) : M_PI / 6;
     simulate_arm();
     return 0;
 }
\ No newline at end of file
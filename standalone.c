@@ -3,6 +3,7 @@
 #include <math.h>
 #include <time.h>
 #include <SDL2/SDL.h>
+#include "vecmath.h"
 
 // This document is Licensed under Creative Commons CC0.
 // To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
@@ -144,12 +145,14 @@ void render_simulation() {
     int origin_x = SCREEN_WIDTH / 2;
     int origin_y = SCREEN_HEIGHT / 2;
 
-    // Calculate positions based on angles
-    int joint2_x = origin_x + (int)(ROD_LENGTH_SCALE * L1 * sin(theta1));
-    int joint2_y = origin_y - (int)(ROD_LENGTH_SCALE * L1 * cos(theta1));
+    // Calculate positions based on angles; both rod angles go through one vectorized sin/cos call
+    double angles[2] = { theta1, theta1 + theta2 }, s[2], c[2];
+    vec_sincos(2, angles, s, c);
+    int joint2_x = origin_x + (int)(ROD_LENGTH_SCALE * L1 * s[0]);
+    int joint2_y = origin_y - (int)(ROD_LENGTH_SCALE * L1 * c[0]);
     
-    int end_x = joint2_x + (int)(ROD_LENGTH_SCALE * L2 * sin(theta1 + theta2));
-    int end_y = joint2_y - (int)(ROD_LENGTH_SCALE * L2 * cos(theta1 + theta2));
+    int end_x = joint2_x + (int)(ROD_LENGTH_SCALE * L2 * s[1]);
+    int end_y = joint2_y - (int)(ROD_LENGTH_SCALE * L2 * c[1]);
 
     // Draw rods
     SDL_SetRenderDrawColor(renderer, 200, 200, 50, 255); // First rod: yellowish
@@ -0,0 +1,229 @@
+import os
+import json
+import fcntl
+from contextlib import contextmanager
+import numpy as np
+
+# This document is Licensed under Creative Commons CC0.
+# To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+# to this document to the public domain worldwide.
+# This document is distributed without any warranty.
+# You should have received a copy of the CC0 Public Domain Dedication along with this document.
+# If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+# Incremental, appendable torque-matching index.
+#
+# Rows have the robot-control.txt layout: six thetas (the match key) followed by two torques.
+# New rows go to an in-memory table; flush() writes it as an immutable segment on disk. Segments are
+# organized in tiers like an LSM tree: once a tier holds FANOUT segments they are merged into one
+# segment of the next tier, so compaction touches only the small, recent segments and never rebuilds
+# the whole index. Each segment is sorted by a 2-D grid cell of (End_Theta1, End_Theta2); nearest-row
+# queries visit a growing block of cells and stop once no unvisited cell can hold a closer row, so
+# the result is the exact Euclidean nearest neighbour (or k nearest) over all six thetas.
+# Segments are .npy files loaded with mmap, so reopening an index costs milliseconds.
+# Several processes may append to one index: flush() holds an exclusive lock on the directory and
+# rereads the manifest first, so segments written by the others are kept and names never collide.
+
+COLUMNS = ['prev_theta1', 'prev_theta2', 'start_theta1', 'start_theta2',
+           'end_theta1', 'end_theta2', 'tau1', 'tau2']
+KEY_COLUMNS = 6          # Thetas used for matching
+CELL_COLUMNS = (4, 5)    # End_Theta1, End_Theta2 select the grid cell
+CELL_SIZE = 0.02         # Grid cell edge (rad)
+CELL_OFFSET = 1 << 20    # Keeps cell coordinates positive before packing
+CELL_STRIDE = 1 << 21
+MEMTABLE_LIMIT = 4096    # Rows kept in memory before an automatic flush
+FANOUT = 4               # Segments per tier before they are merged into the next tier
+MAX_RING = 64            # Beyond this many cells out, fall back to scanning the segment
+
+# Function to compute the packed grid cell key for rows (N x 8) or thetas (N x 6)
+def cell_keys(rows):
+    ix = np.floor(rows[:, CELL_COLUMNS[0]] / CELL_SIZE).astype(np.int64) + CELL_OFFSET
+    iy = np.floor(rows[:, CELL_COLUMNS[1]] / CELL_SIZE).astype(np.int64) + CELL_OFFSET
+    return ix * CELL_STRIDE + iy
+
+# Immutable sorted run of rows stored on disk
+class Segment:
+    def __init__(self, directory, name, tier):
+        self.name = name
+        self.tier = tier
+        self.rows = np.load(os.path.join(directory, name + "-rows.npy"), mmap_mode='r')
+        self.keys = np.load(os.path.join(directory, name + "-keys.npy"), mmap_mode='r')
+
+    # Function to write rows as a new segment file pair, sorted by cell key
+    @staticmethod
+    def write(directory, name, rows):
+        rows = np.asarray(rows, dtype=np.float64).reshape(-1, len(COLUMNS))
+        keys = cell_keys(rows)
+        order = np.argsort(keys, kind='stable')
+        for suffix, array in (("-rows.npy", rows[order]), ("-keys.npy", keys[order])):
+            path = os.path.join(directory, name + suffix)
+            np.save(path + ".tmp.npy", array)
+            os.replace(path + ".tmp.npy", path)
+
+    # Function to delete the segment files once a merge has replaced them
+    def remove(self, directory):
+        del self.rows, self.keys
+        for suffix in ("-rows.npy", "-keys.npy"):
+            os.remove(os.path.join(directory, self.name + suffix))
+
+    # Function to collect the rows stored in a square block of cells around (cx, cy)
+    def block(self, cx, cy, ring):
+        parts = []
+        for ix in range(cx - ring, cx + ring + 1):
+            lo_key = ix * CELL_STRIDE + cy - ring
+            lo = np.searchsorted(self.keys, lo_key, side='left')
+            hi = np.searchsorted(self.keys, lo_key + 2 * ring, side='right')
+            if hi > lo:
+                parts.append(self.rows[lo:hi])
+        return parts
+
+class TorqueIndex:
+    def __init__(self, directory):
+        self.directory = directory
+        os.makedirs(directory, exist_ok=True)
+        self.memtable = []
+        self.memtable_array = None
+        self.segments = []
+        self.next_id = 0
+        self._read_manifest()
+
+    def __len__(self):
+        return sum(len(s.rows) for s in self.segments) + len(self.memtable)
+
+    # Function to load the set of segments recorded on disk
+    def _read_manifest(self):
+        manifest_path = os.path.join(self.directory, "manifest.json")
+        if os.path.exists(manifest_path):
+            with open(manifest_path, "r", encoding="utf-8") as file:
+                manifest = json.load(file)
+            self.next_id = manifest["next_id"]
+            self.segments = [Segment(self.directory, s["name"], s["tier"]) for s in manifest["segments"]]
+
+    # Function to hold the index's writer lock, shared with other processes appending to it
+    @contextmanager
+    def _writer_lock(self):
+        with open(os.path.join(self.directory, "lock"), "w") as lock:
+            fcntl.flock(lock, fcntl.LOCK_EX)
+            try:
+                yield
+            finally:
+                fcntl.flock(lock, fcntl.LOCK_UN)
+
+    # Function to atomically record the current set of segments
+    def _write_manifest(self):
+        manifest = {
+            "next_id": self.next_id,
+            "segments": [{"name": s.name, "tier": s.tier} for s in self.segments]
+        }
+        path = os.path.join(self.directory, "manifest.json")
+        with open(path + ".tmp", "w", encoding="utf-8") as file:
+            json.dump(manifest, file)
+        os.replace(path + ".tmp", path)
+
+    # Function to append rows (each a sequence of 8 values or a dict with COLUMNS keys)
+    def insert(self, rows):
+        for row in rows:
+            if isinstance(row, dict):
+                row = [row[c] for c in COLUMNS]
+            self.memtable.append([float(v) for v in row[:len(COLUMNS)]])
+        self.memtable_array = None
+        if len(self.memtable) >= MEMTABLE_LIMIT:
+            self.flush()
+
+    # Function to persist the in-memory rows as a tier-0 segment and compact full tiers
+    def flush(self):
+        if not self.memtable:
+            return
+        with self._writer_lock():
+            # Another process may have flushed or compacted since this one last looked
+            self._read_manifest()
+            name = f"seg-{self.next_id:06d}"
+            self.next_id += 1
+            Segment.write(self.directory, name, self.memtable)
+            self.segments.append(Segment(self.directory, name, 0))
+            self.memtable = []
+            self.memtable_array = None
+            self.compact()
+            self._write_manifest()
+
+    # Function to merge every tier that has reached FANOUT segments into the next tier (under the writer lock)
+    def compact(self):
+        tier = 0
+        while True:
+            members = [s for s in self.segments if s.tier == tier]
+            if not members:
+                if not any(s.tier > tier for s in self.segments):
+                    break
+            elif len(members) >= FANOUT:
+                name = f"seg-{self.next_id:06d}"
+                self.next_id += 1
+                Segment.write(self.directory, name, np.concatenate([np.asarray(s.rows) for s in members]))
+                merged = Segment(self.directory, name, tier + 1)
+                self.segments = [s for s in self.segments if s.tier != tier] + [merged]
+                # The manifest must stop naming the old segments before their files go away
+                self._write_manifest()
+                for s in members:
+                    s.remove(self.directory)
+            tier += 1
+
+    # Function to find the stored row nearest to six query thetas; returns an 8-value array or None
+    def nearest(self, thetas):
+        rows = self.nearest_k(thetas, 1)
+        return rows[0] if len(rows) else None
+
+    # Function to find the k stored rows nearest to six query thetas; returns a (<= k) x 8 array, nearest first
+    def nearest_k(self, thetas, k):
+        query = np.asarray(thetas, dtype=np.float64)[:KEY_COLUMNS]
+        best = np.empty((0, len(COLUMNS)))
+        best_dist = np.empty(0)
+
+        # Function to keep the k nearest of some best rows and new candidates
+        def merge(rows, dist, candidates):
+            candidate_dist = np.sum((candidates[:, :KEY_COLUMNS] - query) ** 2, axis=1)
+            if len(candidate_dist) > k:
+                keep = np.argpartition(candidate_dist, k)[:k]
+                candidates, candidate_dist = candidates[keep], candidate_dist[keep]
+            rows, dist = np.concatenate([rows, candidates]), np.concatenate([dist, candidate_dist])
+            order = np.argsort(dist, kind='stable')[:k]
+            return rows[order], dist[order]
+
+        if self.memtable:
+            if self.memtable_array is None:
+                self.memtable_array = np.array(self.memtable)
+            best, best_dist = merge(best, best_dist, self.memtable_array)
+
+        cx = int(np.floor(query[CELL_COLUMNS[0]] / CELL_SIZE)) + CELL_OFFSET
+        cy = int(np.floor(query[CELL_COLUMNS[1]] / CELL_SIZE)) + CELL_OFFSET
+        for segment in self.segments:
+            ring = 1
+            while True:
+                # Each block contains the previous one, so only the final block of a segment is merged
+                parts = segment.block(cx, cy, ring)
+                if parts:
+                    candidates = np.concatenate(parts) if len(parts) > 1 else np.asarray(parts[0])
+                    rows, dist = merge(best, best_dist, candidates)
+                else:
+                    rows, dist = best, best_dist
+                # Rows outside the block are at least ring * CELL_SIZE away in a cell column
+                if len(dist) == k and dist[-1] <= (ring * CELL_SIZE) ** 2:
+                    best, best_dist = rows, dist
+                    break
+                if ring >= MAX_RING:
+                    best, best_dist = merge(best, best_dist, np.asarray(segment.rows))
+                    break
+                ring *= 2
+        return np.array(best)
+
+# Function to parse a file in the robot-control.txt format into rows for TorqueIndex.insert()
+def read_rows(path):
+    rows = []
+    with open(path, "r", encoding="utf-8") as file:
+        for line in file:
+            values = line.strip().split('\t')
+            if len(values) < len(COLUMNS):
+                continue
+            try:
+                rows.append([float(v) for v in values[:len(COLUMNS)]])
+            except ValueError:
+                continue  # Header line
+    return rows
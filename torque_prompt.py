@@ -0,0 +1,84 @@
+import re
+from torque_index import TorqueIndex, KEY_COLUMNS, read_rows
+
+# This document is Licensed under Creative Commons CC0.
+# To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+# to this document to the public domain worldwide.
+# This document is distributed without any warranty.
+# You should have received a copy of the CC0 Public Domain Dedication along with this document.
+# If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+# Question building and answer parsing shared by the LLM torque controllers and robot-control-bench.py.
+#
+# Instead of the whole robot-control.txt, each question carries the reference line and only the
+# CANDIDATES rows nearest to it from the torque index (see torque_index.py), nearest first. Every
+# number is written with a fixed sign and precision, so a question is one instruction, one header,
+# one query line and CANDIDATES rows of constant width, however large the reference dataset grows.
+
+CANDIDATES = 8           # Nearest rows sent with each question
+THETA_FORMAT = "{:+.4f}" # 0.1 mrad, finer than the spacing of neighbouring rows
+TORQUE_FORMAT = "{:+.2f}"
+HEADER = "pa pb sa sb ea eb ta tb" # Digit-free, so an answer that echoes the labels still parses
+
+# Function to open the torque index, seeding it from robot-control.txt on first use
+def open_index(index_dir="robot-control.idx", dataset_path="robot-control.txt"):
+    index = TorqueIndex(index_dir)
+    if len(index) == 0:
+        try:
+            index.insert(read_rows(dataset_path))
+            index.flush()
+        except FileNotFoundError:
+            print(f"Warning: {dataset_path} not found. Using empty dataset.")
+    return index
+
+# Function to encode six thetas, and optionally two torques, as one space separated line
+def encode_row(values):
+    thetas = [THETA_FORMAT.format(float(v)) for v in values[:KEY_COLUMNS]]
+    torques = [TORQUE_FORMAT.format(float(v)) for v in values[KEY_COLUMNS:KEY_COLUMNS + 2]]
+    return " ".join(thetas + torques)
+
+# Function to build the question for six query thetas from their nearest rows in the index
+def build_question(index, thetas, k=CANDIDATES):
+    rows = index.nearest_k(thetas, k) if index is not None else []
+    lines = [
+        "I give a reference line and a data table. Find the closest line of theta numbers pa..eb in the table "
+        "for the reference line. Give me its torques ta and tb. Give me just the two numbers, nothing else.",
+        encode_row(thetas),
+        "",
+        HEADER
+    ]
+    lines.extend(encode_row(row) for row in rows)
+    return "\n".join(lines)
+
+# Improved parsing for the torque values
+def parse_torques(response_text):
+    # Torques are written with a fraction part, so numbers with one come first; this skips stray integers
+    # such as labels or list markers ("t1: +4.55, t2: -2.48")
+    numbers = re.findall(r'[+-]?\d+\.\d+', response_text)
+    if len(numbers) >= 2:
+        return float(numbers[0]), float(numbers[1])
+
+    # Then the standard regex pattern for numbers
+    numbers = re.findall(r'-?\d+\.?\d*', response_text)
+    
+    if len(numbers) >= 2:
+        return float(numbers[0]), float(numbers[1])
+    
+    # If standard pattern fails, try other formats
+    # Try comma-separated pattern (e.g. "-10.5, 15.3")
+    comma_pattern = re.search(r'(-?\d+\.?\d*)\s*,\s*(-?\d+\.?\d*)', response_text)
+    if comma_pattern:
+        return float(comma_pattern.group(1)), float(comma_pattern.group(2))
+    
+    # Try newline-separated pattern (e.g. "-10.5\n15.3")
+    newline_pattern = re.search(r'(-?\d+\.?\d*)\s*[\n\r]+\s*(-?\d+\.?\d*)', response_text)
+    if newline_pattern:
+        return float(newline_pattern.group(1)), float(newline_pattern.group(2))
+    
+    # Try tab-separated pattern (e.g. "-10.5\t15.3")
+    tab_pattern = re.search(r'(-?\d+\.?\d*)\s*\t\s*(-?\d+\.?\d*)', response_text)
+    if tab_pattern:
+        return float(tab_pattern.group(1)), float(tab_pattern.group(2))
+    
+    # If all patterns fail, return None
+    return None
@@ -0,0 +1,370 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "physics-dual.h"
+
+// This document is Licensed under Creative Commons CC0.
+// To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+// to this document to the public domain worldwide.
+// This document is distributed without any warranty.
+// You should have received a copy of the CC0 Public Domain Dedication along with this document.
+// If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+/*
+gcc -O3 -march=native tune.c -o tune -lm; ./tune
+*/
+
+// Gradient-based tuning of the leg with the differentiable physics of physics-dual.h.
+// One dual rollout gives the tracking cost together with its gradient with respect to the four PD gains and
+// the two rod masses, where finite differences need two rollouts per parameter.
+//
+//   ./tune [start_theta1 start_theta2 [seed]]    Tune KP1/KD1/KP2/KD2 by gradient descent on the rollout cost
+//   ./tune --identify robot-control.txt          Estimate M1/M2 from recorded simulation output (Gauss-Newton)
+//   ./tune --sensitivities                       Print the trajectory with dθ/dparameter for every step
+//   ./tune --check                               Check the rollouts against physics.h and the gradient against
+//                                                finite differences, and time both; run after changing physics.h
+
+#define STEPS 1000              // 10 s rollout; fixed length, since the early exit of simulate_arm() is not smooth
+#define TORQUE_WEIGHT 1e-4      // Weight of the squared control torque in the cost, relative to squared angle
+#define LEARNING_RATE 0.05      // Adam step in log-gain space
+#define IDENTIFY_ITERATIONS 20
+
+static const char *param_names[PARAMS] = { "KP1", "KD1", "KP2", "KD2", "M1", "M2" };
+static const double nominal[PARAMS] = { KP1, KD1, KP2, KD2, M1, M2 };
+
+// Function to read a monotonic clock in seconds
+static double now_seconds() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Function to run one rollout and return its cost ∫ θ1² + θ2² + w·(u1² + u2²) dt with the gradient in .d.
+// The noise is reseeded from seed, so every evaluation sees the same noise sequence.
+Dual rollout_cost(const double params[PARAMS], double start_theta1, double start_theta2, unsigned int seed) {
+    DualParams p = dual_params(params);
+    Dual theta1 = dual_const(start_theta1), omega1 = dual_const(0.0);
+    Dual theta2 = dual_const(start_theta2), omega2 = dual_const(0.0);
+    Dual cost = dual_const(0.0);
+
+    srand(seed);
+    for (int i = 0; i < STEPS; i++) {
+        Dual tau1, tau2;
+        dual_gravitational_torques(&p, theta1, theta2, &tau1, &tau2);
+        Dual gravity1 = tau1, gravity2 = tau2;
+        dual_control_torques(&p, theta1, omega1, theta2, omega2, &tau1, &tau2);
+
+        Dual u1 = dual_sub(tau1, gravity1), u2 = dual_sub(tau2, gravity2);
+        Dual error = dual_add(dual_mul(theta1, theta1), dual_mul(theta2, theta2));
+        Dual effort = dual_add(dual_mul(u1, u1), dual_mul(u2, u2));
+        cost = dual_add(cost, dual_scale(dual_add(error, dual_scale(effort, TORQUE_WEIGHT)), DT));
+
+        dual_simulate_step(&p, &theta1, &omega1, &theta2, &omega2, tau1, tau2);
+    }
+    return cost;
+}
+
+// Function to run the same rollout in plain doubles (the value only, for finite differences).
+// Like physics-dual.h this restates the physics.h step with the masses as parameters; --check compares both
+// with physics.h itself, so run it after every change to physics.h.
+double rollout_cost_value(const double params[PARAMS], double start_theta1, double start_theta2, unsigned int seed) {
+    double theta1 = start_theta1, omega1 = 0.0, theta2 = start_theta2, omega2 = 0.0;
+    double m1 = params[PARAM_M1], m2 = params[PARAM_M2];
+    double cost = 0.0;
+
+    srand(seed);
+    for (int i = 0; i < STEPS; i++) {
+        double tau1 = -m1 * G * L1 * sin(theta1) - m2 * G * L1 * sin(theta1);
+        double tau2 = -m2 * G * L2 * sin(theta2);
+        double u1 = (-params[PARAM_KP1] * theta1 - params[PARAM_KD1] * omega1) *
+                    (1.0 + (PHYSICS_RAND() % 201 - 100) / 1000.0);
+        double u2 = (-params[PARAM_KP2] * theta2 - params[PARAM_KD2] * omega2) *
+                    (1.0 + (PHYSICS_RAND() % 201 - 100) / 1000.0);
+        tau1 += u1;
+        tau2 += u2;
+        cost += (theta1 * theta1 + theta2 * theta2 + TORQUE_WEIGHT * (u1 * u1 + u2 * u2)) * DT;
+
+        if (use_contact) {
+            double contact_tau1, contact_tau2;
+            compute_contact_torques(theta1, omega1, theta2, omega2, &contact_tau1, &contact_tau2);
+            tau1 += contact_tau1;
+            tau2 += contact_tau2;
+        }
+        omega1 += tau1 / (m1 * L1 * L1) * DT;
+        omega2 += tau2 / (m2 * L2 * L2) * DT;
+        theta1 += omega1 * DT;
+        theta2 += omega2 * DT;
+    }
+    return cost;
+}
+
+// Function to compute the rollout cost at the nominal parameters with the physics.h functions themselves,
+// the reference rollout_cost() and rollout_cost_value() must reproduce
+double physics_cost(double start_theta1, double start_theta2, unsigned int seed) {
+    double theta1 = start_theta1, omega1 = 0.0, theta2 = start_theta2, omega2 = 0.0;
+    double cost = 0.0;
+
+    srand(seed);
+    for (int i = 0; i < STEPS; i++) {
+        double tau1 = 0.0, tau2 = 0.0;
+        compute_gravitational_torques(theta1, theta2, &tau1, &tau2);
+        double gravity1 = tau1, gravity2 = tau2;
+        compute_control_torques(theta1, omega1, theta2, omega2, &tau1, &tau2);
+        double u1 = tau1 - gravity1, u2 = tau2 - gravity2;
+        cost += (theta1 * theta1 + theta2 * theta2 + TORQUE_WEIGHT * (u1 * u1 + u2 * u2)) * DT;
+        simulate_step(&theta1, &omega1, &theta2, &omega2, tau1, tau2);
+    }
+    return cost;
+}
+
+// Function to tune the PD gains with Adam on log-gains (keeps them positive and evens out their scales).
+// Stick-slip in stance makes the cost rough, so the reported gains are the best evaluated, not the last.
+void tune_gains(int iterations, double start_theta1, double start_theta2, unsigned int seed) {
+    double params[PARAMS], best_params[PARAMS], m[4] = { 0 }, v[4] = { 0 };
+    memcpy(params, nominal, sizeof(params));
+    memcpy(best_params, nominal, sizeof(params));
+
+    printf("Iteration\tCost\tKP1\tKD1\tKP2\tKD2\n");
+    double start = now_seconds(), nominal_cost = 0.0;
+    Dual cost = dual_const(0.0), best = dual_const(INFINITY);
+    for (int it = 1; it <= iterations + 1; it++) {
+        cost = rollout_cost(params, start_theta1, start_theta2, seed);
+        printf("%d\t%.6f\t%.3f\t%.3f\t%.3f\t%.3f\n", it, cost.v,
+               params[PARAM_KP1], params[PARAM_KD1], params[PARAM_KP2], params[PARAM_KD2]);
+        if (it == 1) nominal_cost = cost.v;
+        if (cost.v < best.v) {
+            best = cost;
+            memcpy(best_params, params, sizeof(params));
+        }
+        if (it > iterations) break;  // The gains after the last update are evaluated, not updated
+
+        for (int i = 0; i < 4; i++) {
+            double g = cost.d[i] * params[i];  // d cost / d log(gain)
+            m[i] = 0.9 * m[i] + 0.1 * g;
+            v[i] = 0.999 * v[i] + 0.001 * g * g;
+            double m_hat = m[i] / (1.0 - pow(0.9, it)), v_hat = v[i] / (1.0 - pow(0.999, it));
+            params[i] *= exp(-LEARNING_RATE * m_hat / (sqrt(v_hat) + 1e-12));
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    fprintf(stderr, "Tuned in %d rollouts (%.1f ms): cost %.6f (nominal gains %.6f, final gains %.6f), "
+                    "KP1 %.3f KD1 %.3f KP2 %.3f KD2 %.3f\n",
+            iterations + 1, elapsed * 1e3, best.v, nominal_cost, cost.v,
+            best_params[PARAM_KP1], best_params[PARAM_KD1], best_params[PARAM_KP2], best_params[PARAM_KD2]);
+    fprintf(stderr, "Sensitivity to the masses at the tuned gains: dCost/dM1 %.5f, dCost/dM2 %.5f\n",
+            best.d[PARAM_M1], best.d[PARAM_M2]);
+}
+
+// Function to estimate M1 and M2 from rows in the robot-control.txt format.
+// Each row is one step: the start velocity follows from Start - Prev (the integrator sets ω = Δθ/DT), the
+// recorded torques are applied, and the predicted End angles are fitted to the recorded ones.
+int identify_masses(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", path);
+        return 1;
+    }
+    int count = 0, capacity = 1024;
+    double (*rows)[8] = malloc(sizeof(*rows) * capacity);
+    char line[512];
+    while (rows != NULL && fgets(line, sizeof(line), file) != NULL) {
+        double *r = rows[count];
+        if (sscanf(line, "%lf %lf %lf %lf %lf %lf %lf %lf", &r[0], &r[1], &r[2], &r[3], &r[4], &r[5], &r[6], &r[7]) != 8) {
+            continue;  // Header line
+        }
+        if (++count == capacity) {
+            capacity *= 2;
+            double (*grown)[8] = realloc(rows, sizeof(*rows) * capacity);
+            if (grown == NULL) free(rows);
+            rows = grown;
+        }
+    }
+    fclose(file);
+    if (rows == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        return 1;
+    }
+    if (count == 0) {
+        fprintf(stderr, "Error: no data rows in %s\n", path);
+        free(rows);
+        return 1;
+    }
+
+    // Start from half the nominal masses so the fit has something to do
+    double params[PARAMS];
+    memcpy(params, nominal, sizeof(params));
+    params[PARAM_M1] *= 0.5;
+    params[PARAM_M2] *= 0.5;
+
+    printf("Iteration\tRMS_Residual\tM1\tM2\n");
+    for (int it = 0; it < IDENTIFY_ITERATIONS; it++) {
+        DualParams p = dual_params(params);
+        double jtj[2][2] = { { 0 } }, jtr[2] = { 0 }, sum_sq = 0.0;
+        for (int r = 0; r < count; r++) {
+            Dual theta1 = dual_const(rows[r][2]), theta2 = dual_const(rows[r][3]);
+            Dual omega1 = dual_const((rows[r][2] - rows[r][0]) / DT), omega2 = dual_const((rows[r][3] - rows[r][1]) / DT);
+            dual_simulate_step(&p, &theta1, &omega1, &theta2, &omega2, dual_const(rows[r][6]), dual_const(rows[r][7]));
+
+            Dual residuals[2] = { dual_shift(theta1, -rows[r][4]), dual_shift(theta2, -rows[r][5]) };
+            for (int k = 0; k < 2; k++) {
+                double j[2] = { residuals[k].d[PARAM_M1], residuals[k].d[PARAM_M2] };
+                for (int a = 0; a < 2; a++) {
+                    for (int b = 0; b < 2; b++) jtj[a][b] += j[a] * j[b];
+                    jtr[a] += j[a] * residuals[k].v;
+                }
+                sum_sq += residuals[k].v * residuals[k].v;
+            }
+        }
+        printf("%d\t%.3e\t%.5f\t%.5f\n", it, sqrt(sum_sq / (2.0 * count)), params[PARAM_M1], params[PARAM_M2]);
+
+        // Gauss-Newton step: solve (JᵀJ) Δ = -Jᵀr
+        double det = jtj[0][0] * jtj[1][1] - jtj[0][1] * jtj[1][0];
+        if (fabs(det) < 1e-300) {
+            fprintf(stderr, "Error: the data does not excite both joints; masses are not identifiable\n");
+            free(rows);
+            return 1;
+        }
+        double step1 = -(jtj[1][1] * jtr[0] - jtj[0][1] * jtr[1]) / det;
+        double step2 = -(jtj[0][0] * jtr[1] - jtj[1][0] * jtr[0]) / det;
+        params[PARAM_M1] += step1;
+        params[PARAM_M2] += step2;
+        if (fabs(step1) + fabs(step2) < 1e-9) break;
+    }
+    fprintf(stderr, "Identified from %d steps: M1 %.4f kg, M2 %.4f kg (nominal %.4f, %.4f)\n",
+            count, params[PARAM_M1], params[PARAM_M2], M1, M2);
+    free(rows);
+    return 0;
+}
+
+// Function to print the nominal trajectory with the sensitivity of both angles to every parameter
+void print_sensitivities(double start_theta1, double start_theta2, unsigned int seed) {
+    DualParams p = dual_params(nominal);
+    Dual theta1 = dual_const(start_theta1), omega1 = dual_const(0.0);
+    Dual theta2 = dual_const(start_theta2), omega2 = dual_const(0.0);
+
+    printf("Step\tTheta1\tTheta2");
+    for (int k = 1; k <= 2; k++) {
+        for (int i = 0; i < PARAMS; i++) printf("\tdTheta%d/d%s", k, param_names[i]);
+    }
+    printf("\n");
+
+    srand(seed);
+    for (int s = 1; s <= STEPS; s++) {
+        Dual tau1, tau2;
+        dual_gravitational_torques(&p, theta1, theta2, &tau1, &tau2);
+        dual_control_torques(&p, theta1, omega1, theta2, omega2, &tau1, &tau2);
+        dual_simulate_step(&p, &theta1, &omega1, &theta2, &omega2, tau1, tau2);
+
+        printf("%d\t%.6f\t%.6f", s, theta1.v, theta2.v);
+        for (int i = 0; i < PARAMS; i++) printf("\t%.6e", theta1.d[i]);
+        for (int i = 0; i < PARAMS; i++) printf("\t%.6e", theta2.d[i]);
+        printf("\n");
+    }
+}
+
+// Function to compare the dual rollout and its double twin with physics.h, the dual gradient with central finite
+// differences, and time both; returns 0 when they agree.
+// Stance makes the cost so curved that a relative step of 1e-6 can leave the linear range while 1e-8 loses digits
+// to rounding, so each derivative is compared with the closest of three steps. A formula that drifted from
+// physics.h is off at every step.
+int check_gradient(double start_theta1, double start_theta2, unsigned int seed) {
+    enum { REPEATS = 20 };
+    static const double steps[] = { 1e-6, 1e-7, 1e-8 };
+    double params[PARAMS], fd[PARAMS], fd_step[PARAMS];
+    memcpy(params, nominal, sizeof(params));
+
+    double t0 = now_seconds();
+    Dual cost;
+    for (int r = 0; r < REPEATS; r++) cost = rollout_cost(params, start_theta1, start_theta2, seed);
+    double ad_ms = (now_seconds() - t0) * 1e3 / REPEATS;
+
+    t0 = now_seconds();
+    for (int r = 0; r < REPEATS; r++) {
+        for (int i = 0; i < PARAMS; i++) {
+            double h = 1e-6 * params[i], saved = params[i];
+            params[i] = saved + h;
+            double up = rollout_cost_value(params, start_theta1, start_theta2, seed);
+            params[i] = saved - h;
+            double down = rollout_cost_value(params, start_theta1, start_theta2, seed);
+            params[i] = saved;
+            fd[i] = (up - down) / (2.0 * h);
+        }
+    }
+    double fd_ms = (now_seconds() - t0) * 1e3 / REPEATS;
+
+    for (int i = 0; i < PARAMS; i++) {
+        fd_step[i] = steps[0];
+        for (int k = 1; k < (int)(sizeof(steps) / sizeof(steps[0])); k++) {
+            double h = steps[k] * params[i], saved = params[i];
+            params[i] = saved + h;
+            double up = rollout_cost_value(params, start_theta1, start_theta2, seed);
+            params[i] = saved - h;
+            double down = rollout_cost_value(params, start_theta1, start_theta2, seed);
+            params[i] = saved;
+            double estimate = (up - down) / (2.0 * h);
+            if (fabs(estimate - cost.d[i]) < fabs(fd[i] - cost.d[i])) {
+                fd[i] = estimate;
+                fd_step[i] = steps[k];
+            }
+        }
+    }
+
+    double value = rollout_cost_value(params, start_theta1, start_theta2, seed);
+    double reference = physics_cost(start_theta1, start_theta2, seed);
+    int failures = fabs(cost.v - reference) > 1e-9 * fabs(reference) || fabs(value - reference) > 1e-9 * fabs(reference);
+    printf("Cost: physics.h %.10f, dual %.10f, double %.10f\n", reference, cost.v, value);
+    printf("Parameter\tDual\tFiniteDifference\tStep\tRelativeError\n");
+    for (int i = 0; i < PARAMS; i++) {
+        double error = fabs(cost.d[i] - fd[i]) / fmax(fabs(fd[i]), 1e-8);
+        printf("%s\t%.8e\t%.8e\t%.0e\t%.1e\n", param_names[i], cost.d[i], fd[i], fd_step[i], error);
+        failures += error > 1e-5;
+    }
+    printf("Gradient of %d parameters: dual %.2f ms, finite differences %.2f ms (%.1fx)\n",
+           PARAMS, ad_ms, fd_ms, fd_ms / ad_ms);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    const char *identify_path = NULL;
+    int check = 0, sensitivities = 0, iterations = 100;
+    char *args[3];
+    int count = 0;
+    for (int i = 1; i < argc; i++) {
+        int has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--identify") == 0 && has_value) identify_path = argv[++i];
+        else if (strcmp(argv[i], "--iterations") == 0 && has_value) iterations = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--check") == 0) check = 1;
+        else if (strcmp(argv[i], "--sensitivities") == 0) sensitivities = 1;
+        else if (strcmp(argv[i], "--no-contact") == 0) use_contact = 0;
+        else if (strcmp(argv[i], "--ground") == 0 && has_value) ground_y = atof(argv[++i]);
+        else {
+            // Anything else is positional: the start angles, which may be negative, and the seed
+            char *end;
+            strtod(argv[i], &end);
+            if (count == 3 || end == argv[i] || *end != '\0') {
+                fprintf(stderr, "Usage: %s [--check | --identify FILE | --sensitivities] [--iterations N] "
+                                "[--ground Y | --no-contact] [start_theta1 start_theta2 [seed]]\n", argv[0]);
+                return 1;
+            }
+            args[count++] = argv[i];
+        }
+    }
+
+    // Same defaults as simulation.c, with a fixed seed so every rollout sees the same noise
+    double start_theta1 = count > 1 ? atof(args[0]) : M_PI / 6;
+    double start_theta2 = count > 1 ? atof(args[1]) : M_PI / 6;
+    unsigned int seed = count > 2 ? (unsigned int)strtoul(args[2], NULL, 10) : 1;
+
+    if (identify_path != NULL) return identify_masses(identify_path);
+    if (check) return check_gradient(start_theta1, start_theta2, seed);
+    if (sensitivities) {
+        print_sensitivities(start_theta1, start_theta2, seed);
+        return 0;
+    }
+    tune_gains(iterations, start_theta1, start_theta2, seed);
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vecmath.h"
+
+// This document is Licensed under Creative Commons CC0.
+// To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+// to this document to the public domain worldwide.
+// This document is distributed without any warranty.
+// You should have received a copy of the CC0 Public Domain Dedication along with this document.
+// If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+/*
+gcc -O2 vecmath-test.c -o vecmath-test -lm; ./vecmath-test
+*/
+
+// Accuracy test of the vecmath.h sin/cos variants against libm.
+// Prints the maximum absolute and ulp error per variant and range, and exits non-zero if a bound is exceeded.
+
+#define POINTS (1 << 22)
+
+typedef struct {
+    const char *name;
+    vec_sincos_fn fn;
+    int supported;
+} Variant;
+
+typedef struct {
+    const char *name;
+    double lo, hi;
+    double max_abs;    // Bound on the absolute error
+    double max_ulp;    // Bound on the error in ulps of the libm result (ignored when 0)
+} Range;
+
+// Function to measure the distance between a and b in units of the last place of b
+static double ulp_error(double a, double b) {
+    if (a == b) return 0.0;
+    double ulp = nextafter(fabs(b), INFINITY) - fabs(b);
+    return fabs(a - b) / ulp;
+}
+
+int main() {
+    Variant variants[] = {
+        { "scalar", vec_sincos_scalar, 1 },
+#ifdef VECMATH_X86
+        { "avx2", vec_sincos_avx2, __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") },
+        { "avx512", vec_sincos_avx512, __builtin_cpu_supports("avx512f") },
+#endif
+    };
+    Range ranges[] = {
+        // The fdlibm kernels are within 1 ulp for an exact reduced argument; dropping the tail of the reduced
+        // argument adds at most half an ulp of it, so 1.5 ulp (1.5 ulp of values just below 1 in absolute terms)
+        // bounds the error with margin over the 1 ulp measured
+        { "|x| <= 2pi", -2.0 * M_PI, 2.0 * M_PI, 1.7e-16, 1.5 },
+        { "|x| <= 1e6", -1e6, 1e6, 1.7e-16, 0.0 },
+        { "1e6 < x <= 1e9", 1.000001e6, 1e9, 0.0, 0.0 },  // Beyond the fast range: must match libm exactly
+    };
+    static const double specials[] = { 0.0, -0.0, M_PI / 4, -M_PI / 4, M_PI / 2, M_PI, 1e-300, 5e-324,
+                                       VECMATH_RANGE, -VECMATH_RANGE, INFINITY, -INFINITY, NAN };
+    const int n_specials = sizeof(specials) / sizeof(specials[0]);
+
+    double *x = malloc(sizeof(double) * POINTS);
+    double *s = malloc(sizeof(double) * POINTS);
+    double *c = malloc(sizeof(double) * POINTS);
+    if (x == NULL || s == NULL || c == NULL) return 1;
+
+    int failures = 0;
+    srand(1);
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        if (!variants[v].supported) {
+            printf("%-7s not supported on this CPU, skipped\n", variants[v].name);
+            continue;
+        }
+        for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+            Range *range = &ranges[r];
+            for (int i = 0; i < POINTS; i++) {
+                x[i] = range->lo + (range->hi - range->lo) * ((double)rand() / RAND_MAX);
+            }
+            // Odd count so the SIMD loops also exercise their scalar tail
+            variants[v].fn(POINTS - 1, x, s, c);
+
+            double max_abs = 0.0, max_ulp = 0.0;
+            for (int i = 0; i < POINTS - 1; i++) {
+                double es = fabs(s[i] - sin(x[i])), ec = fabs(c[i] - cos(x[i]));
+                if (es > max_abs) max_abs = es;
+                if (ec > max_abs) max_abs = ec;
+                double us = ulp_error(s[i], sin(x[i])), uc = ulp_error(c[i], cos(x[i]));
+                if (us > max_ulp && fabs(sin(x[i])) > 1e-3) max_ulp = us;
+                if (uc > max_ulp && fabs(cos(x[i])) > 1e-3) max_ulp = uc;
+            }
+            int ok = max_abs <= range->max_abs && (range->max_ulp == 0.0 || max_ulp <= range->max_ulp);
+            printf("%-7s %-14s max abs error %.3g, max ulp error %.2f (|result| > 1e-3)  %s\n",
+                   variants[v].name, range->name, max_abs, max_ulp, ok ? "ok" : "FAIL");
+            failures += !ok;
+        }
+
+        // Special values must follow libm, including signed zeros, infinities and NaN
+        variants[v].fn(n_specials, specials, s, c);
+        for (int i = 0; i < n_specials; i++) {
+            double ls = sin(specials[i]), lc = cos(specials[i]);
+            int ok = (isnan(ls) ? isnan(s[i]) : fabs(s[i] - ls) <= 2.3e-16) &&
+                     (isnan(lc) ? isnan(c[i]) : fabs(c[i] - lc) <= 2.3e-16) &&
+                     (specials[i] != 0.0 || signbit(s[i]) == signbit(ls));
+            if (!ok) {
+                printf("%-7s special value %g: got (%g, %g), libm (%g, %g)  FAIL\n",
+                       variants[v].name, specials[i], s[i], c[i], ls, lc);
+                failures++;
+            }
+        }
+    }
+
+    free(x);
+    free(s);
+    free(c);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures ? 1 : 0;
+}
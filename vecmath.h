@@ -0,0 +1,227 @@
+#ifndef VECMATH_H
+#define VECMATH_H
+
+#include <math.h>
+#include <stdint.h>
+
+// The SIMD variants and their runtime dispatch exist only on x86; elsewhere vec_sincos() is the scalar loop
+#if defined(__x86_64__) || defined(__i386__)
+#define VECMATH_X86 1
+#include <immintrin.h>
+#endif
+
+// This document is Licensed under Creative Commons CC0.
+// To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
+// to this document to the public domain worldwide.
+// This document is distributed without any warranty.
+// You should have received a copy of the CC0 Public Domain Dedication along with this document.
+// If not, see https://creativecommons.org/publicdomain/zero/1.0/legalcode.
+
+// Vectorized double precision sin/cos over arrays, for batched physics and forward kinematics.
+//
+// All variants use the same algorithm: Cody-Waite reduction by π/2 with a three-part constant, then the
+// fdlibm minimax polynomials on [-π/4, π/4]. On x86 the AVX2/FMA and AVX-512 variants are compiled with target
+// attributes, so no -m flags are needed, and vec_sincos() picks the widest one the CPU supports on first use.
+//
+// Accuracy against glibc libm (checked by vecmath-test.c, 2^22 points per range):
+//   |x| <= 2π:   max absolute error 1.1e-16, max 1 ulp where |result| > 1e-3
+//   |x| <= 1e6:  max absolute error 1.1e-16 (reduction keeps |r| <= π/4 exact to ~2^-60)
+//   |x| >  1e6, NaN, ±inf: the lane is computed by libm, so results match libm exactly
+// Signed zeros follow libm. The variants differ only by FMA contraction, so they may disagree in the last bit.
+
+#define VECMATH_RANGE 1e6    // Largest |x| handled by the fast reduction
+
+static const double vm_two_over_pi = 6.36619772367581382433e-01;
+static const double vm_pio2_1 = 1.57079632673412561417e+00;   // First 33 bits of π/2
+static const double vm_pio2_2 = 6.07710050630396597660e-11;   // Next 33 bits
+static const double vm_pio2_3 = 2.02226624879595063154e-21;   // Remainder
+static const double vm_round = 6755399441055744.0;            // 1.5·2^52, rounds to integer when added
+
+static const double vm_s1 = -1.66666666666666324348e-01;
+static const double vm_s2 = 8.33333333332248946124e-03;
+static const double vm_s3 = -1.98412698298579493134e-04;
+static const double vm_s4 = 2.75573137070700676789e-06;
+static const double vm_s5 = -2.50507602534068634195e-08;
+static const double vm_s6 = 1.58969099521155010221e-10;
+
+static const double vm_c1 = 4.16666666666666019037e-02;
+static const double vm_c2 = -1.38888888888741095749e-03;
+static const double vm_c3 = 2.48015872894767294178e-05;
+static const double vm_c4 = -2.75573143513906633035e-07;
+static const double vm_c5 = 2.08757232129817482790e-09;
+static const double vm_c6 = -1.13596475577881948265e-11;
+
+// Function to compute sin and cos of one value with the shared algorithm (scalar reference)
+static inline void vm_sincos1(double x, double *s, double *c) {
+    if (!(fabs(x) <= VECMATH_RANGE)) {
+        *s = sin(x);
+        *c = cos(x);
+        return;
+    }
+    double kd = x * vm_two_over_pi + vm_round;
+    int64_t q;
+    __builtin_memcpy(&q, &kd, sizeof(q));
+    kd -= vm_round;
+    double r = ((x - kd * vm_pio2_1) - kd * vm_pio2_2) - kd * vm_pio2_3;
+
+    double z = r * r;
+    double ps = r + r * z * (vm_s1 + z * (vm_s2 + z * (vm_s3 + z * (vm_s4 + z * (vm_s5 + z * vm_s6)))));
+    // cos as w + ((1 - w) - z/2 + ...) with w = 1 - z/2: the rounding error of w is recovered exactly (fdlibm)
+    double hz = 0.5 * z, w = 1.0 - hz;
+    double pc = w + (((1.0 - w) - hz) + z * z * (vm_c1 + z * (vm_c2 + z * (vm_c3 + z * (vm_c4 + z * (vm_c5 + z * vm_c6))))));
+    ps = copysign(ps, r); // sin(r) has the sign of r on [-π/4, π/4]; this keeps sin(-0) = -0
+
+    // Quadrant: sin = (ps, pc, -ps, -pc)[q & 3], cos = (pc, -ps, -pc, ps)[q & 3]
+    double sv = (q & 1) ? pc : ps;
+    double cv = (q & 1) ? ps : pc;
+    *s = (q & 2) ? -sv : sv;
+    *c = ((q + 1) & 2) ? -cv : cv;
+}
+
+// Function to compute sin/cos of n values with the scalar algorithm; s or c may be NULL
+static void vec_sincos_scalar(int n, const double *x, double *s, double *c) {
+    for (int i = 0; i < n; i++) {
+        double sv, cv;
+        vm_sincos1(x[i], &sv, &cv);
+        if (s) s[i] = sv;
+        if (c) c[i] = cv;
+    }
+}
+
+#ifdef VECMATH_X86
+__attribute__((target("avx2,fma")))
+static void vec_sincos_avx2(int n, const double *x, double *s, double *c) {
+    const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    const __m256d range = _mm256_set1_pd(VECMATH_RANGE);
+    const __m256i one = _mm256_set1_epi64x(1), two = _mm256_set1_epi64x(2);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d xv = _mm256_loadu_pd(x + i);
+        // Lanes outside the fast range (or NaN) are redone by the scalar path
+        if (_mm256_movemask_pd(_mm256_cmp_pd(_mm256_and_pd(xv, abs_mask), range, _CMP_LE_OQ)) != 0xf) {
+            vec_sincos_scalar(4, x + i, s ? s + i : NULL, c ? c + i : NULL);
+            continue;
+        }
+        __m256d kd = _mm256_fmadd_pd(xv, _mm256_set1_pd(vm_two_over_pi), _mm256_set1_pd(vm_round));
+        __m256i q = _mm256_castpd_si256(kd);
+        kd = _mm256_sub_pd(kd, _mm256_set1_pd(vm_round));
+        __m256d r = _mm256_fnmadd_pd(kd, _mm256_set1_pd(vm_pio2_1), xv);
+        r = _mm256_fnmadd_pd(kd, _mm256_set1_pd(vm_pio2_2), r);
+        r = _mm256_fnmadd_pd(kd, _mm256_set1_pd(vm_pio2_3), r);
+
+        __m256d z = _mm256_mul_pd(r, r);
+        __m256d ps = _mm256_fmadd_pd(z, _mm256_set1_pd(vm_s6), _mm256_set1_pd(vm_s5));
+        ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd(vm_s4));
+        ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd(vm_s3));
+        ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd(vm_s2));
+        ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd(vm_s1));
+        ps = _mm256_fmadd_pd(_mm256_mul_pd(r, z), ps, r);
+        ps = _mm256_or_pd(_mm256_and_pd(ps, abs_mask), _mm256_andnot_pd(abs_mask, r));
+
+        __m256d pc = _mm256_fmadd_pd(z, _mm256_set1_pd(vm_c6), _mm256_set1_pd(vm_c5));
+        pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd(vm_c4));
+        pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd(vm_c3));
+        pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd(vm_c2));
+        pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd(vm_c1));
+        __m256d hz = _mm256_mul_pd(_mm256_set1_pd(0.5), z);
+        __m256d w = _mm256_sub_pd(_mm256_set1_pd(1.0), hz);
+        __m256d w_error = _mm256_sub_pd(_mm256_sub_pd(_mm256_set1_pd(1.0), w), hz);
+        pc = _mm256_add_pd(w, _mm256_fmadd_pd(_mm256_mul_pd(z, z), pc, w_error));
+
+        __m256d swap = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(q, one), one));
+        __m256d sv = _mm256_blendv_pd(ps, pc, swap);
+        __m256d cv = _mm256_blendv_pd(pc, ps, swap);
+        __m256d s_sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(q, two), 62));
+        __m256d c_sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(_mm256_add_epi64(q, one), two), 62));
+        if (s) _mm256_storeu_pd(s + i, _mm256_xor_pd(sv, s_sign));
+        if (c) _mm256_storeu_pd(c + i, _mm256_xor_pd(cv, c_sign));
+    }
+    vec_sincos_scalar(n - i, x + i, s ? s + i : NULL, c ? c + i : NULL);
+}
+
+__attribute__((target("avx512f")))
+static void vec_sincos_avx512(int n, const double *x, double *s, double *c) {
+    const __m512i abs_mask = _mm512_set1_epi64(0x7fffffffffffffffLL);
+    const __m512d range = _mm512_set1_pd(VECMATH_RANGE);
+    const __m512i one = _mm512_set1_epi64(1), two = _mm512_set1_epi64(2);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d xv = _mm512_loadu_pd(x + i);
+        if (_mm512_cmp_pd_mask(_mm512_abs_pd(xv), range, _CMP_LE_OQ) != 0xff) {
+            vec_sincos_scalar(8, x + i, s ? s + i : NULL, c ? c + i : NULL);
+            continue;
+        }
+        __m512d kd = _mm512_fmadd_pd(xv, _mm512_set1_pd(vm_two_over_pi), _mm512_set1_pd(vm_round));
+        __m512i q = _mm512_castpd_si512(kd);
+        kd = _mm512_sub_pd(kd, _mm512_set1_pd(vm_round));
+        __m512d r = _mm512_fnmadd_pd(kd, _mm512_set1_pd(vm_pio2_1), xv);
+        r = _mm512_fnmadd_pd(kd, _mm512_set1_pd(vm_pio2_2), r);
+        r = _mm512_fnmadd_pd(kd, _mm512_set1_pd(vm_pio2_3), r);
+
+        __m512d z = _mm512_mul_pd(r, r);
+        __m512d ps = _mm512_fmadd_pd(z, _mm512_set1_pd(vm_s6), _mm512_set1_pd(vm_s5));
+        ps = _mm512_fmadd_pd(z, ps, _mm512_set1_pd(vm_s4));
+        ps = _mm512_fmadd_pd(z, ps, _mm512_set1_pd(vm_s3));
+        ps = _mm512_fmadd_pd(z, ps, _mm512_set1_pd(vm_s2));
+        ps = _mm512_fmadd_pd(z, ps, _mm512_set1_pd(vm_s1));
+        ps = _mm512_fmadd_pd(_mm512_mul_pd(r, z), ps, r);
+        ps = _mm512_castsi512_pd(_mm512_or_si512(_mm512_and_si512(_mm512_castpd_si512(ps), abs_mask),
+                                                 _mm512_andnot_si512(abs_mask, _mm512_castpd_si512(r))));
+
+        __m512d pc = _mm512_fmadd_pd(z, _mm512_set1_pd(vm_c6), _mm512_set1_pd(vm_c5));
+        pc = _mm512_fmadd_pd(z, pc, _mm512_set1_pd(vm_c4));
+        pc = _mm512_fmadd_pd(z, pc, _mm512_set1_pd(vm_c3));
+        pc = _mm512_fmadd_pd(z, pc, _mm512_set1_pd(vm_c2));
+        pc = _mm512_fmadd_pd(z, pc, _mm512_set1_pd(vm_c1));
+        __m512d hz = _mm512_mul_pd(_mm512_set1_pd(0.5), z);
+        __m512d w = _mm512_sub_pd(_mm512_set1_pd(1.0), hz);
+        __m512d w_error = _mm512_sub_pd(_mm512_sub_pd(_mm512_set1_pd(1.0), w), hz);
+        pc = _mm512_add_pd(w, _mm512_fmadd_pd(_mm512_mul_pd(z, z), pc, w_error));
+
+        __mmask8 swap = _mm512_test_epi64_mask(q, one);
+        __m512d sv = _mm512_mask_blend_pd(swap, ps, pc);
+        __m512d cv = _mm512_mask_blend_pd(swap, pc, ps);
+        __m512i s_sign = _mm512_slli_epi64(_mm512_and_si512(q, two), 62);
+        __m512i c_sign = _mm512_slli_epi64(_mm512_and_si512(_mm512_add_epi64(q, one), two), 62);
+        if (s) _mm512_storeu_pd(s + i, _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(sv), s_sign)));
+        if (c) _mm512_storeu_pd(c + i, _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(cv), c_sign)));
+    }
+    vec_sincos_scalar(n - i, x + i, s ? s + i : NULL, c ? c + i : NULL);
+}
+
+#endif
+
+typedef void (*vec_sincos_fn)(int n, const double *x, double *s, double *c);
+
+// Function to pick the widest variant the running CPU supports
+static vec_sincos_fn vec_sincos_select(void) {
+#ifdef VECMATH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return vec_sincos_avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return vec_sincos_avx2;
+#endif
+    return vec_sincos_scalar;
+}
+
+// Function to compute s[i] = sin(x[i]) and c[i] = cos(x[i]); either output may be NULL.
+// Safe to call from several threads at once: the first calls may all select, but they pick the same variant and
+// publish it with an atomic store.
+static inline void vec_sincos(int n, const double *x, double *s, double *c) {
+    static vec_sincos_fn impl = NULL;
+    vec_sincos_fn fn = __atomic_load_n(&impl, __ATOMIC_ACQUIRE);
+    if (fn == NULL) {
+        fn = vec_sincos_select();
+        __atomic_store_n(&impl, fn, __ATOMIC_RELEASE);
+    }
+    fn(n, x, s, c);
+}
+
+static inline void vec_sin(int n, const double *x, double *s) {
+    vec_sincos(n, x, s, NULL);
+}
+
+static inline void vec_cos(int n, const double *x, double *c) {
+    vec_sincos(n, x, NULL, c);
+}
+
+#endif
@@ -2,7 +2,11 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <stdint.h>
+#include <poll.h>
+#include <unistd.h>
 #include <SDL2/SDL.h>
+#include "physics.h"
 
 // This document is Licensed under Creative Commons CC0.
 // To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring rights
@@ -15,19 +19,13 @@
 gcc view.c -o view -lSDL2 -lm $(sdl2-config --cflags --libs); ./simulation | ./view
 */
 
-// Physics constants (from cerebras.c)
-#define G 9.81       // Gravity (m/s²)
-#define L1 1.0       // Length of first rod (m)
-#define L2 1.5       // Length of second rod (m)
-#define M1 1.0       // Mass of first rod (kg)
-#define M2 1.5       // Mass of second rod (kg)
-
 // Display constants
 #define SCREEN_WIDTH 800
-#define SCREEN_HEIGHT 600
+#define SCENE_HEIGHT 600         // Height of the leg drawing
+#define PLOT_HEIGHT 200          // Height of the time-series panel below it
+#define SCREEN_HEIGHT (SCENE_HEIGHT + PLOT_HEIGHT)
 #define WINDOW_TITLE "Humanoid Physics Visualization"
 #define ROD_LENGTH_SCALE 100.0f  // Pixels per meter
-#define MAX_DATA_LINES 1000      // Maximum number of data lines to store
 
 #define LEG_WIDTH 20        // Width of the leg segments
 #define KNEE_RADIUS 8       // Radius of the knee joint
@@ -35,22 +33,57 @@ gcc view.c -o view -lSDL2 -lm $(sdl2-config --cflags --libs); ./simulation | ./v
 #define FOOT_LENGTH 40      // Length of the foot
 #define FOOT_HEIGHT 10      // Height of the foot
 
-// Structure to hold one line of simulation data
+// Plot panel constants
+#define PLOT_MARGIN 20                                    // Left and right margin of the plot (pixels)
+#define PLOT_WIDTH (SCREEN_WIDTH - 2 * PLOT_MARGIN)       // One plot column per pixel
+#define PLOT_GAP 10                                       // Space around the two strips (pixels)
+#define STRIP_HEIGHT ((PLOT_HEIGHT - 3 * PLOT_GAP) / 2)   // Angles strip above, torques strip below
+#define MIN_VIEW_SPAN 16                                  // Fewest samples the plot zooms in to
+#define READ_BUDGET_MS 8                                  // Time per rendered frame spent reading stdin
+
+// Min/max pyramid: level 0 summarizes PYRAMID_BASE samples per bucket, each next level PYRAMID_FANOUT buckets
+#define PYRAMID_BASE 8
+#define PYRAMID_FANOUT 4
+#define PYRAMID_LEVELS 16   // Covers 8·4^15 samples, far beyond what fits in memory
+
+// Plotted channels (the End_Theta and Torque columns of the simulation output)
+enum { THETA1, THETA2, TAU1, TAU2, CHANNELS };
+
+// Minimum and maximum of each bucket at one pyramid level
 typedef struct {
-    double prev_theta1;
-    double prev_theta2;
-    double start_theta1;
-    double start_theta2;
-    double end_theta1;
-    double end_theta2;
-    double tau1;
-    double tau2;
-} SimulationData;
-
-// Array to store all simulation data
-SimulationData data[MAX_DATA_LINES];
-int data_count = 0;
-int current_frame = 0;
+    float *min;
+    float *max;
+    long count;
+    long capacity;
+} PyramidLevel;
+
+// One channel of the run: every sample plus its min/max pyramid, extended as samples arrive
+typedef struct {
+    float *samples;
+    PyramidLevel levels[PYRAMID_LEVELS];
+} Series;
+
+// All simulation data read so far
+Series series[CHANNELS];
+size_t data_count = 0;
+size_t data_capacity = 0;
+size_t current_frame = 0;
+
+// Streaming input: stdin is read a little every frame, and parsed rows wait in a block to be appended
+char input_buffer[1 << 16];
+int input_length = 0;
+int input_open = 1;
+double input_block[CHANNELS][PHYSICS_BLOCK];
+int input_block_count = 0;
+
+// Visible range of the plot in samples; follow_all keeps the whole run in view while it grows
+double view_start = 0.0;
+double view_span = 0.0;
+int follow_all = 1;
+int dragging = 0;
+int drag_moved = 0;
+int drag_x = 0;
+double drag_start = 0.0;
 
 // Graphics variables
 SDL_Window* window = NULL;
@@ -60,32 +93,180 @@ int paused = 0;
 int step_mode = 0;
 int playback_speed = 1; // Frames to advance per render
 
-// Function to read simulation data from stdin
-int read_simulation_data() {
-    char line[256];
-    int line_count = 0;
-    
-    // Skip header line
-    if (fgets(line, sizeof(line), stdin) == NULL) {
-        return 0;
+// Function to resize a float array; returns 0 when out of memory or when the size does not fit in size_t
+int resize_floats(float **array, size_t capacity) {
+    if (capacity > SIZE_MAX / sizeof(float)) return 0;
+    float *resized = realloc(*array, sizeof(float) * capacity);
+    if (resized == NULL) return 0;
+    *array = resized;
+    return 1;
+}
+
+// Function to compute the number of samples covered by one bucket of a pyramid level (-1 for raw samples)
+long bucket_size(int level) {
+    long size = 1;
+    if (level >= 0) {
+        size = PYRAMID_BASE;
+        for (int l = 0; l < level; l++) size *= PYRAMID_FANOUT;
     }
-    
-    // Read data lines
-    while (fgets(line, sizeof(line), stdin) != NULL && line_count < MAX_DATA_LINES) {
-        if (sscanf(line, "%lf\t%lf\t%lf\t%lf\t%lf\t%lf\t%lf\t%lf",
-                  &data[line_count].prev_theta1,
-                  &data[line_count].prev_theta2,
-                  &data[line_count].start_theta1,
-                  &data[line_count].start_theta2,
-                  &data[line_count].end_theta1,
-                  &data[line_count].end_theta2,
-                  &data[line_count].tau1,
-                  &data[line_count].tau2) == 8) {
-            line_count++;
+    return size;
+}
+
+// Function to append a bucket to a pyramid level
+int push_bucket(PyramidLevel *level, float min, float max) {
+    if (level->count == level->capacity) {
+        long capacity = level->capacity ? level->capacity * 2 : 1024;
+        if (!resize_floats(&level->min, capacity) || !resize_floats(&level->max, capacity)) return 0;
+        level->capacity = capacity;
+    }
+    level->min[level->count] = min;
+    level->max[level->count] = max;
+    level->count++;
+    return 1;
+}
+
+// Function to extend the pyramid once the series holds count samples.
+// A bucket is added only when the buckets below it are complete, so building costs O(1) amortized per sample.
+int update_pyramid(Series *s, size_t count) {
+    if (count % PYRAMID_BASE != 0) return 1;
+
+    const float *x = s->samples + count - PYRAMID_BASE;
+    float min = x[0], max = x[0];
+    for (int i = 1; i < PYRAMID_BASE; i++) {
+        min = fminf(min, x[i]);
+        max = fmaxf(max, x[i]);
+    }
+    if (!push_bucket(&s->levels[0], min, max)) return 0;
+
+    for (int l = 0; l + 1 < PYRAMID_LEVELS && s->levels[l].count % PYRAMID_FANOUT == 0; l++) {
+        const PyramidLevel *level = &s->levels[l];
+        long first = level->count - PYRAMID_FANOUT;
+        min = level->min[first];
+        max = level->max[first];
+        for (int i = 1; i < PYRAMID_FANOUT; i++) {
+            min = fminf(min, level->min[first + i]);
+            max = fmaxf(max, level->max[first + i]);
         }
+        if (!push_bucket(&s->levels[l + 1], min, max)) return 0;
     }
-    
-    return line_count;
+    return 1;
+}
+
+// Function to widen [*min, *max] by samples [lo, hi) of a series, read as whole buckets of one level.
+// lo and hi snap down to bucket edges, so neighbouring plot columns share edges and every bucket is read once.
+// Samples past the last complete bucket come from the finer levels, down to the raw samples (level -1).
+void series_range(const Series *s, int level, long lo, long hi, float *min, float *max) {
+    if (level < 0) {
+        for (long i = lo; i < hi; i++) {
+            *min = fminf(*min, s->samples[i]);
+            *max = fmaxf(*max, s->samples[i]);
+        }
+        return;
+    }
+
+    const PyramidLevel *p = &s->levels[level];
+    long size = bucket_size(level);
+    long first = lo / size;
+    long last = hi / size < p->count ? hi / size : p->count;
+    for (long i = first; i < last; i++) {
+        *min = fminf(*min, p->min[i]);
+        *max = fmaxf(*max, p->max[i]);
+    }
+
+    long tail = (first > p->count ? first : p->count) * size;
+    if (hi > tail) series_range(s, level - 1, tail, hi, min, max);
+}
+
+// Function to append the pending block of parsed rows to the series
+void flush_input_block() {
+    int n = input_block_count;
+    input_block_count = 0;
+    if (n == 0 || !input_open) return;
+
+    if (data_count + n > data_capacity) {
+        // Doubling keeps appends O(1) amortized; stop reading before the capacity would wrap around
+        int ok = data_capacity <= SIZE_MAX / 2;
+        size_t capacity = data_capacity ? data_capacity * 2 : 4096;
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            ok = ok && resize_floats(&series[ch].samples, capacity);
+        }
+        if (!ok) {
+            printf("Out of memory after %zu lines of simulation data; ignoring the rest.\n", data_count);
+            input_open = 0;
+            return;
+        }
+        data_capacity = capacity;
+    }
+
+    for (int i = 0; i < n; i++) {
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            series[ch].samples[data_count] = (float)input_block[ch][i];
+        }
+        data_count++;
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            if (!update_pyramid(&series[ch], data_count)) {
+                printf("Out of memory after %zu lines of simulation data; ignoring the rest.\n", data_count);
+                input_open = 0;
+                return;
+            }
+        }
+    }
+}
+
+// Function to parse one line of simulation data into the pending block; the header and malformed lines are skipped
+void parse_line(const char *line) {
+    double values[8];
+    const char *p = line;
+    char *end;
+    for (int i = 0; i < 8; i++) {
+        values[i] = strtod(p, &end);
+        if (end == p) return;
+        p = end;
+    }
+
+    input_block[THETA1][input_block_count] = values[4];
+    input_block[THETA2][input_block_count] = values[5];
+    input_block[TAU1][input_block_count] = values[6];
+    input_block[TAU2][input_block_count] = values[7];
+    if (++input_block_count == PHYSICS_BLOCK) flush_input_block();
+}
+
+// Function to read simulation data from stdin without blocking the window for long.
+// The first poll waits up to wait_ms (-1 waits for data); reading stops after budget_ms.
+void read_simulation_data(int wait_ms, Uint32 budget_ms) {
+    Uint32 start = SDL_GetTicks();
+    struct pollfd input = { STDIN_FILENO, POLLIN, 0 };
+
+    while (input_open && poll(&input, 1, wait_ms) > 0) {
+        ssize_t n = read(STDIN_FILENO, input_buffer + input_length, sizeof(input_buffer) - 1 - input_length);
+        if (n <= 0) {
+            // End of input; the last line may lack a newline
+            input_buffer[input_length] = '\0';
+            parse_line(input_buffer);
+            input_length = 0;
+            flush_input_block();
+            input_open = 0;
+            printf("Read %zu lines of simulation data.\n", data_count);
+            break;
+        }
+        input_length += n;
+
+        // Parse the complete lines and keep the partial last one for the next read
+        char *line = input_buffer;
+        char *newline;
+        while ((newline = memchr(line, '\n', input_buffer + input_length - line)) != NULL) {
+            *newline = '\0';
+            parse_line(line);
+            line = newline + 1;
+        }
+        input_length -= line - input_buffer;
+        memmove(input_buffer, line, input_length);
+        if (input_length == sizeof(input_buffer) - 1) input_length = 0; // Not a data line; drop it
+
+        wait_ms = 0;
+        if (SDL_GetTicks() - start >= budget_ms) break;
+    }
+    flush_input_block();
 }
 
 // Initialize SDL
@@ -122,12 +303,133 @@ void shutdown_graphics() {
     SDL_Quit();
 }
 
+// Function to keep the visible plot range inside the data
+void clamp_view() {
+    if (follow_all || view_span > data_count) view_span = data_count;
+    if (view_span < MIN_VIEW_SPAN) view_span = data_count < MIN_VIEW_SPAN ? data_count : MIN_VIEW_SPAN;
+    if (follow_all || view_start < 0.0) view_start = 0.0;
+    if (view_start > data_count - view_span) view_start = data_count - view_span;
+}
+
+// Function to find the sample under a window x coordinate of the plot
+size_t plot_sample_at(int x) {
+    double sample = floor(view_start + (x - PLOT_MARGIN) * view_span / PLOT_WIDTH);
+    return sample < 0.0 ? 0 : sample >= data_count ? data_count - 1 : (size_t)sample;
+}
+
+// Function to zoom the plot by factor (below 1 zooms in), keeping the sample under window x in place
+void zoom_plot(double factor, int x) {
+    clamp_view();
+    double anchor = view_start + (x - PLOT_MARGIN) * view_span / PLOT_WIDTH;
+    view_span *= factor;
+    follow_all = view_span >= data_count;
+    view_start = anchor - (x - PLOT_MARGIN) * view_span / PLOT_WIDTH;
+    clamp_view();
+}
+
+// Function to draw the time-series panel: angles in the upper strip, torques in the lower one.
+// Each pixel column reads the coarsest pyramid level whose buckets still fit in it, so at most about
+// PYRAMID_FANOUT buckets per column: the cost is O(PLOT_WIDTH) at any zoom and for any length of run.
+void render_plot() {
+    static float column_min[CHANNELS][PLOT_WIDTH], column_max[CHANNELS][PLOT_WIDTH];
+    static const Uint8 colors[CHANNELS][3] = {
+        { 200, 200, 50 },   // Theta1: yellowish
+        { 50, 200, 200 },   // Theta2: bluish
+        { 50, 255, 50 },    // Torque1: green
+        { 255, 120, 50 }    // Torque2: orange
+    };
+
+    // Panel background
+    SDL_SetRenderDrawColor(renderer, 20, 20, 40, 255);
+    SDL_Rect panel = { 0, SCENE_HEIGHT, SCREEN_WIDTH, PLOT_HEIGHT };
+    SDL_RenderFillRect(renderer, &panel);
+    if (data_count == 0) return;
+
+    clamp_view();
+    double per_column = view_span / PLOT_WIDTH;
+    int level = -1;
+    while (level + 1 < PYRAMID_LEVELS && bucket_size(level + 1) <= per_column) level++;
+
+    // Min/max of every channel in every pixel column
+    for (int c = 0; c < PLOT_WIDTH; c++) {
+        long lo = (long)(view_start + c * per_column);
+        long hi = (long)(view_start + (c + 1) * per_column);
+        if (hi <= lo) hi = lo + 1;  // Zoomed in past one sample per pixel
+        if (hi > (long)data_count) hi = (long)data_count;
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            column_min[ch][c] = INFINITY;
+            column_max[ch][c] = -INFINITY;
+            if (lo < hi) series_range(&series[ch], level, lo, hi, &column_min[ch][c], &column_max[ch][c]);
+        }
+    }
+
+    for (int strip = 0; strip < 2; strip++) {
+        int top = SCENE_HEIGHT + PLOT_GAP + strip * (STRIP_HEIGHT + PLOT_GAP);
+
+        // Scale the strip to the visible range of its two channels
+        float low = INFINITY, high = -INFINITY;
+        for (int ch = 2 * strip; ch < 2 * strip + 2; ch++) {
+            for (int c = 0; c < PLOT_WIDTH; c++) {
+                low = fminf(low, column_min[ch][c]);
+                high = fmaxf(high, column_max[ch][c]);
+            }
+        }
+        if (!(low <= high)) continue;
+        if (high - low < 1e-6f) {
+            low -= 0.5f;
+            high += 0.5f;
+        }
+        float scale = (STRIP_HEIGHT - 1) / (high - low);
+
+        // Strip frame and zero line
+        SDL_SetRenderDrawColor(renderer, 50, 50, 80, 255);
+        SDL_Rect frame = { PLOT_MARGIN, top, PLOT_WIDTH, STRIP_HEIGHT };
+        SDL_RenderDrawRect(renderer, &frame);
+        if (low < 0.0f && high > 0.0f) {
+            int zero_y = top + STRIP_HEIGHT - 1 - (int)((0.0f - low) * scale);
+            SDL_RenderDrawLine(renderer, PLOT_MARGIN, zero_y, PLOT_MARGIN + PLOT_WIDTH - 1, zero_y);
+        }
+
+        // One vertical line per column, stretched to meet the previous column so the trace stays connected
+        for (int ch = 2 * strip; ch < 2 * strip + 2; ch++) {
+            SDL_SetRenderDrawColor(renderer, colors[ch][0], colors[ch][1], colors[ch][2], 255);
+            for (int c = 0; c < PLOT_WIDTH; c++) {
+                float min = column_min[ch][c], max = column_max[ch][c];
+                if (!(min <= max)) continue;
+                if (c > 0 && column_min[ch][c - 1] <= column_max[ch][c - 1]) {
+                    min = fminf(min, column_max[ch][c - 1]);
+                    max = fmaxf(max, column_min[ch][c - 1]);
+                }
+                int y_top = top + STRIP_HEIGHT - 1 - (int)((max - low) * scale);
+                int y_bottom = top + STRIP_HEIGHT - 1 - (int)((min - low) * scale);
+                SDL_RenderDrawLine(renderer, PLOT_MARGIN + c, y_top, PLOT_MARGIN + c, y_bottom);
+            }
+        }
+    }
+
+    // Current frame marker
+    if (current_frame >= view_start && current_frame < view_start + view_span) {
+        int x = PLOT_MARGIN + (int)((current_frame - view_start) / per_column);
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+        SDL_RenderDrawLine(renderer, x, SCENE_HEIGHT + PLOT_GAP, x, SCREEN_HEIGHT - PLOT_GAP - 1);
+    }
+
+    // Position of the visible range within the whole run
+    int bar_y = SCREEN_HEIGHT - PLOT_GAP / 2;
+    SDL_SetRenderDrawColor(renderer, 50, 50, 80, 255);
+    SDL_RenderDrawLine(renderer, PLOT_MARGIN, bar_y, PLOT_MARGIN + PLOT_WIDTH - 1, bar_y);
+    SDL_SetRenderDrawColor(renderer, 100, 180, 255, 255);
+    SDL_RenderDrawLine(renderer, PLOT_MARGIN + (int)(PLOT_WIDTH * view_start / data_count), bar_y,
+                       PLOT_MARGIN + (int)(PLOT_WIDTH * (view_start + view_span) / data_count) - 1, bar_y);
+}
+
 // Render the current frame of simulation
-void render_simulation(int frame) {
+void render_simulation(size_t frame) {
     if (frame >= data_count) return;
     
     // Get current data
-    SimulationData* current = &data[frame];
+    double theta1 = series[THETA1].samples[frame], theta2 = series[THETA2].samples[frame];
+    double tau1 = series[TAU1].samples[frame], tau2 = series[TAU2].samples[frame];
     
     // Clear screen
     SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255); // Dark grey background
@@ -135,18 +437,23 @@ void render_simulation(int frame) {
 
     // Define the origin point (hip joint)
     int origin_x = SCREEN_WIDTH / 2;
-    int origin_y = SCREEN_HEIGHT / 2;
+    int origin_y = SCENE_HEIGHT / 2;
 
-    // Calculate joint positions based on angles
-    int knee_x = origin_x + (int)(ROD_LENGTH_SCALE * L1 * sin(current->end_theta1));
-    int knee_y = origin_y - (int)(ROD_LENGTH_SCALE * L1 * cos(current->end_theta1));
-    
-    int ankle_x = knee_x + (int)(ROD_LENGTH_SCALE * L2 * sin(current->end_theta1 + current->end_theta2));
-    int ankle_y = knee_y - (int)(ROD_LENGTH_SCALE * L2 * cos(current->end_theta1 + current->end_theta2));
+    // Joint positions of the drawn frame relative to the hip (physics.h convention: y up, the leg hanging down),
+    // and from them the leg segment directions
+    double pose_knee_x, pose_knee_y, pose_ankle_x, pose_ankle_y;
+    forward_kinematics_batch(1, &theta1, &theta2, &pose_knee_x, &pose_knee_y, &pose_ankle_x, &pose_ankle_y);
+    double thigh_sin = pose_knee_x / L1;
+    double thigh_cos = pose_knee_y / L1;
+    double shin_sin = (pose_ankle_x - pose_knee_x) / L2;
+    double shin_cos = (pose_ankle_y - pose_knee_y) / L2;
 
-    // Calculate angles for drawing the leg segments
-    float thigh_angle = current->end_theta1;
-    float shin_angle = current->end_theta1 + current->end_theta2;
+    // Joint positions on screen, where y grows downward
+    int knee_x = origin_x + (int)(ROD_LENGTH_SCALE * L1 * thigh_sin);
+    int knee_y = origin_y - (int)(ROD_LENGTH_SCALE * L1 * thigh_cos);
+    
+    int ankle_x = knee_x + (int)(ROD_LENGTH_SCALE * L2 * shin_sin);
+    int ankle_y = knee_y - (int)(ROD_LENGTH_SCALE * L2 * shin_cos);
     
     // Calculate the vertices for the thigh (upper leg)
     SDL_Point thigh_points[4];
@@ -154,8 +461,8 @@ void render_simulation(int frame) {
     int half_width = LEG_WIDTH / 2;
     
     // Calculate perpendicular offsets to the thigh line
-    int dx_perp = (int)(half_width * cos(thigh_angle));
-    int dy_perp = (int)(half_width * sin(thigh_angle));
+    int dx_perp = (int)(half_width * thigh_cos);
+    int dy_perp = (int)(half_width * thigh_sin);
     
     // Four corners of the thigh rectangle
     thigh_points[0].x = origin_x - dx_perp;
@@ -174,8 +481,8 @@ void render_simulation(int frame) {
     SDL_Point shin_points[4];
     
     // Calculate perpendicular offsets to the shin line
-    dx_perp = (int)(half_width * cos(shin_angle));
-    dy_perp = (int)(half_width * sin(shin_angle));
+    dx_perp = (int)(half_width * shin_cos);
+    dy_perp = (int)(half_width * shin_sin);
     
     // Four corners of the shin rectangle
     shin_points[0].x = knee_x - dx_perp;
@@ -190,18 +497,17 @@ void render_simulation(int frame) {
     shin_points[3].x = ankle_x - dx_perp;
     shin_points[3].y = ankle_y + dy_perp;
     
-    // Calculate foot points
+    // Calculate foot points: the sole runs from the ankle, perpendicular to the shin, so it lies flat on the
+    // ground when the leg hangs straight; the heel side rises FOOT_HEIGHT up the shin
     SDL_Point foot_points[4];
-    float foot_angle = shin_angle - M_PI/2; // Perpendicular to shin
-    
-    int foot_dx = (int)(FOOT_LENGTH * cos(foot_angle));
-    int foot_dy = (int)(FOOT_LENGTH * sin(foot_angle));
+    int foot_dx = (int)(FOOT_LENGTH * -shin_cos);
+    int foot_dy = (int)(FOOT_LENGTH * -shin_sin);
     
-    foot_points[0].x = ankle_x - (int)(half_width * cos(shin_angle));
-    foot_points[0].y = ankle_y + (int)(half_width * sin(shin_angle));
+    foot_points[0].x = ankle_x;
+    foot_points[0].y = ankle_y;
     
-    foot_points[1].x = ankle_x + (int)(half_width * cos(shin_angle));
-    foot_points[1].y = ankle_y - (int)(half_width * sin(shin_angle));
+    foot_points[1].x = ankle_x - (int)(FOOT_HEIGHT * shin_sin);
+    foot_points[1].y = ankle_y + (int)(FOOT_HEIGHT * shin_cos);
     
     foot_points[2].x = foot_points[1].x + foot_dx;
     foot_points[2].y = foot_points[1].y + foot_dy;
@@ -214,14 +520,24 @@ void render_simulation(int frame) {
     
     // Draw vertical grid lines
     for (int x = 0; x < SCREEN_WIDTH; x += 50) {
-        SDL_RenderDrawLine(renderer, x, 0, x, SCREEN_HEIGHT);
+        SDL_RenderDrawLine(renderer, x, 0, x, SCENE_HEIGHT);
     }
     
     // Draw horizontal grid lines
-    for (int y = 0; y < SCREEN_HEIGHT; y += 50) {
+    for (int y = 0; y < SCENE_HEIGHT; y += 50) {
         SDL_RenderDrawLine(renderer, 0, y, SCREEN_WIDTH, y);
     }
     
+    // Draw the ground the simulation used, at its height below the hip
+    if (use_contact) {
+        int ground_screen_y = origin_y - (int)(ROD_LENGTH_SCALE * ground_y);
+        SDL_SetRenderDrawColor(renderer, 160, 140, 100, 255); // Sand
+        SDL_RenderDrawLine(renderer, 0, ground_screen_y, SCREEN_WIDTH, ground_screen_y);
+        for (int x = 0; x < SCREEN_WIDTH; x += 12) {
+            SDL_RenderDrawLine(renderer, x, ground_screen_y + 8, x + 8, ground_screen_y);
+        }
+    }
+
     // Draw thigh outline (blueprint style)
     SDL_SetRenderDrawColor(renderer, 100, 180, 255, 255); // Light blue for blueprint
     
@@ -298,11 +614,11 @@ void render_simulation(int frame) {
     SDL_Rect tau1_rect = {
         origin_x - bar_width/2,
         origin_y + 20,
-        (int)(bar_width * fabs(current->tau1) / 50.0), // Scale to reasonable size
+        (int)(bar_width * fabs(tau1) / 50.0), // Scale to reasonable size
         bar_height
     };
     
-    if (current->tau1 >= 0) {
+    if (tau1 >= 0) {
         SDL_SetRenderDrawColor(renderer, 50, 255, 50, 255); // Green for positive
         tau1_rect.x = origin_x;
     } else {
@@ -315,11 +631,11 @@ void render_simulation(int frame) {
     SDL_Rect tau2_rect = {
         knee_x - bar_width/2,
         knee_y + 20,
-        (int)(bar_width * fabs(current->tau2) / 50.0), // Scale to reasonable size
+        (int)(bar_width * fabs(tau2) / 50.0), // Scale to reasonable size
         bar_height
     };
     
-    if (current->tau2 >= 0) {
+    if (tau2 >= 0) {
         SDL_SetRenderDrawColor(renderer, 50, 255, 50, 255); // Green for positive
         tau2_rect.x = knee_x;
     } else {
@@ -358,7 +674,7 @@ void render_simulation(int frame) {
     // Draw data text in top-left corner
     char data_text[512];
     sprintf(data_text, 
-            "Frame: %d/%d\n"
+            "Frame: %zu/%zu%s\n"
             "Theta1: %.4f rad\n"
             "Theta2: %.4f rad\n"
             "Torque1: %.2f Nm\n"
@@ -370,10 +686,12 @@ void render_simulation(int frame) {
             "S: Step Mode Toggle\n"
             "+/-: Speed Up/Down\n"
             "R: Reset to Start\n"
+            "Wheel/Up/Down: Zoom Plot\n"
+            "Drag/Click: Pan Plot/Seek\n"
+            "A: Show Whole Run\n"
             "Q/Esc: Quit",
-            frame + 1, data_count,
-            current->end_theta1, current->end_theta2,
-            current->tau1, current->tau2);
+            frame + 1, data_count, input_open ? " (reading)" : "",
+            theta1, theta2, tau1, tau2);
     
     // Render the data as a series of text lines
     int y_offset = 10;
@@ -396,20 +714,32 @@ void render_simulation(int frame) {
         line = strtok(NULL, "\n");
     }
 
+    render_plot();
+
     // Present the rendered frame
     SDL_RenderPresent(renderer);
 }
 
-int main() {
-    // Read simulation data from stdin
-    data_count = read_simulation_data();
+int main(int argc, char **argv) {
+    // The ground options of the simulation run, so the drawn ground matches it
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-contact") == 0) use_contact = 0;
+        else if (strcmp(argv[i], "--ground") == 0 && i + 1 < argc) ground_y = atof(argv[++i]);
+        else {
+            fprintf(stderr, "Usage: %s [--ground Y | --no-contact] < simulation output\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Wait for the first simulation data; the rest streams in while the window is open
+    while (input_open && data_count == 0) {
+        read_simulation_data(-1, READ_BUDGET_MS);
+    }
     if (data_count == 0) {
         printf("No simulation data read from stdin. Exiting.\n");
         return 1;
     }
     
-    printf("Read %d lines of simulation data.\n", data_count);
-    
     // Initialize graphics
     if (!initialize_graphics()) {
         return 1;
@@ -427,6 +757,29 @@ int main() {
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) {
                 running = 0;
+            } else if (event.type == SDL_MOUSEWHEEL) {
+                int mouse_x, mouse_y;
+                SDL_GetMouseState(&mouse_x, &mouse_y);
+                if (mouse_y >= SCENE_HEIGHT && event.wheel.y != 0) {
+                    zoom_plot(event.wheel.y > 0 ? 0.8 : 1.25, mouse_x);
+                }
+            } else if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT &&
+                       event.button.y >= SCENE_HEIGHT) {
+                dragging = 1;
+                drag_moved = 0;
+                drag_x = event.button.x;
+                drag_start = view_start;
+            } else if (event.type == SDL_MOUSEMOTION && dragging) {
+                if (abs(event.motion.x - drag_x) > 2) drag_moved = 1;
+                if (drag_moved) {
+                    follow_all = 0;
+                    view_start = drag_start - (event.motion.x - drag_x) * view_span / PLOT_WIDTH;
+                    clamp_view();
+                }
+            } else if (event.type == SDL_MOUSEBUTTONUP && event.button.button == SDL_BUTTON_LEFT && dragging) {
+                // A click without dragging seeks to the frame under the cursor
+                dragging = 0;
+                if (!drag_moved) current_frame = plot_sample_at(event.button.x);
             } else if (event.type == SDL_KEYDOWN) {
                 switch (event.key.keysym.sym) {
                     case SDLK_ESCAPE:
@@ -449,9 +802,9 @@ int main() {
                         break;
                     case SDLK_LEFT:
                         if (step_mode || paused) {
-                            current_frame = (current_frame - 1 + data_count) % data_count;
+                            current_frame = (current_frame + data_count - 1) % data_count;
                         } else {
-                            current_frame = (current_frame - 10 + data_count) % data_count;
+                            current_frame = (current_frame + data_count - 10 % data_count) % data_count;
                         }
                         break;
                     case SDLK_r:
@@ -464,10 +817,24 @@ int main() {
                     case SDLK_MINUS:
                         playback_speed = playback_speed > 1 ? playback_speed - 1 : 1;
                         break;
+                    case SDLK_UP:
+                        zoom_plot(0.5, SCREEN_WIDTH / 2);
+                        break;
+                    case SDLK_DOWN:
+                        zoom_plot(2.0, SCREEN_WIDTH / 2);
+                        break;
+                    case SDLK_a:
+                        follow_all = 1;
+                        break;
                 }
             }
         }
         
+        // Take in more data while the simulation is still writing
+        if (input_open) {
+            read_simulation_data(0, READ_BUDGET_MS);
+        }
+
         // Update frame if not paused
         Uint32 current_time = SDL_GetTicks();
         if (!paused && current_time - last_time > frame_delay) {